@@ -0,0 +1,461 @@
+//
+//  DisplayListPainter.cpp
+//
+//  A PPlot Painter Subclass that records the painter calls
+//  into a compact binary command list, which can be replayed
+//  into any other painter or saved to a file.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "DisplayListPainter.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace SVGChart {
+    using namespace std;
+
+    namespace {
+        const char kMagic[8] = {'P', 'P', 'L', 'O', 'T', 'D', 'L', '1'};
+
+        // everything is stored little endian, so files move between machines
+        void appendUInt32(vector<unsigned char> &out, unsigned long value) {
+            out.push_back((unsigned char)(value & 0xFF));
+            out.push_back((unsigned char)((value >> 8) & 0xFF));
+            out.push_back((unsigned char)((value >> 16) & 0xFF));
+            out.push_back((unsigned char)((value >> 24) & 0xFF));
+        }
+
+        void appendBytes(vector<unsigned char> &out, const string &bytes) {
+            appendUInt32(out, bytes.size());
+            out.insert(out.end(), bytes.begin(), bytes.end());
+        }
+
+        class Reader {
+        public:
+            Reader(const unsigned char *data, size_t size): data(data), size(size) {}
+
+            bool atEnd() const { return pos >= size; }
+            bool isValid() const { return valid; }
+            size_t position() const { return pos; }
+
+            const unsigned char *readRaw(size_t count) {
+                if (!valid || count > size - pos) {
+                    valid = false;
+                    return nullptr;
+                }
+                const unsigned char *raw = data + pos;
+                pos += count;
+                return raw;
+            }
+
+            int readByte() {
+                const unsigned char *raw = readRaw(1);
+                return raw ? raw[0] : 0;
+            }
+
+            unsigned long readUInt32() {
+                const unsigned char *raw = readRaw(4);
+                if (!raw) {
+                    return 0;
+                }
+                return (unsigned long)raw[0] | (unsigned long)raw[1] << 8 | (unsigned long)raw[2] << 16 | (unsigned long)raw[3] << 24;
+            }
+
+            int readInt() {
+                unsigned long value = readUInt32();
+                return value & 0x80000000UL ? -(int)(0xFFFFFFFFUL - value) - 1 : (int)value;
+            }
+
+            float readFloat() {
+                uint32_t bits = (uint32_t)readUInt32();
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                return value;
+            }
+
+            string readBytes() {
+                unsigned long count = readUInt32();
+                const unsigned char *raw = readRaw(count);
+                return raw ? string((const char *)raw, count) : string();
+            }
+
+        private:
+            const unsigned char *data;
+            size_t size;
+            size_t pos = 0;
+            bool valid = true;
+        };
+
+        string encodeStyle(const PStyle &style) {
+            vector<unsigned char> out;
+            appendUInt32(out, (unsigned long)style.mFontSize);
+            appendBytes(out, style.mFont);
+            appendUInt32(out, (unsigned long)style.mPenWidth);
+            appendBytes(out, style.mPenStyle);
+            appendUInt32(out, style.mVar.size());
+            for (const auto &var : style.mVar) {
+                appendBytes(out, var.first);
+                appendBytes(out, var.second);
+            }
+            return string(out.begin(), out.end());
+        }
+
+        bool decodeStyle(const string &encoded, PStyle &style) {
+            Reader reader((const unsigned char *)encoded.data(), encoded.size());
+            style.mFontSize = reader.readInt();
+            style.mFont = reader.readBytes();
+            style.mPenWidth = reader.readInt();
+            style.mPenStyle = reader.readBytes();
+            unsigned long count = reader.readUInt32();
+            style.mVar.clear();
+            for (unsigned long i = 0; i < count && reader.isValid(); i++) {
+                string name = reader.readBytes();
+                style.mVar[name] = reader.readBytes();
+            }
+            return reader.isValid() && reader.atEnd();
+        }
+
+        // Decodes commands and issues them on painter, or only checks them
+        // when painter is null. Returns false on a malformed list.
+        bool runCommands(const vector<unsigned char> &commands, const vector<string> &strings, const vector<PStyle> &styles,
+                         Painter *painter, long &count) {
+            Reader reader(commands.data(), commands.size());
+            count = 0;
+            while (!reader.atEnd()) {
+                int opcode = reader.readByte();
+                switch (opcode) {
+                case DisplayListPainter::kDrawLine: {
+                    float x1 = reader.readFloat(), y1 = reader.readFloat(), x2 = reader.readFloat(), y2 = reader.readFloat();
+                    if (painter && reader.isValid()) {
+                        painter->DrawLine(x1, y1, x2, y2);
+                    }
+                    break;
+                }
+                case DisplayListPainter::kFillRect:
+                case DisplayListPainter::kInvertRect:
+                case DisplayListPainter::kSetClipRect: {
+                    int x = reader.readInt(), y = reader.readInt(), w = reader.readInt(), h = reader.readInt();
+                    if (painter && reader.isValid()) {
+                        if (opcode == DisplayListPainter::kFillRect) {
+                            painter->FillRect(x, y, w, h);
+                        } else if (opcode == DisplayListPainter::kInvertRect) {
+                            painter->InvertRect(x, y, w, h);
+                        } else {
+                            painter->SetClipRect(x, y, w, h);
+                        }
+                    }
+                    break;
+                }
+                case DisplayListPainter::kSetLineColor:
+                case DisplayListPainter::kSetFillColor: {
+                    int r = reader.readByte(), g = reader.readByte(), b = reader.readByte();
+                    if (painter && reader.isValid()) {
+                        if (opcode == DisplayListPainter::kSetLineColor) {
+                            painter->SetLineColor(r, g, b);
+                        } else {
+                            painter->SetFillColor(r, g, b);
+                        }
+                    }
+                    break;
+                }
+                case DisplayListPainter::kDrawText:
+                case DisplayListPainter::kDrawRotatedText: {
+                    int x = reader.readInt(), y = reader.readInt();
+                    float degrees = opcode == DisplayListPainter::kDrawRotatedText ? reader.readFloat() : 0;
+                    unsigned long index = reader.readUInt32();
+                    if (index >= strings.size()) {
+                        return false;
+                    }
+                    if (painter && reader.isValid()) {
+                        if (opcode == DisplayListPainter::kDrawText) {
+                            painter->DrawText(x, y, strings[index].c_str());
+                        } else {
+                            painter->DrawRotatedText(x, y, degrees, strings[index].c_str());
+                        }
+                    }
+                    break;
+                }
+                case DisplayListPainter::kSetStyle: {
+                    unsigned long index = reader.readUInt32();
+                    if (index >= styles.size()) {
+                        return false;
+                    }
+                    if (painter && reader.isValid()) {
+                        painter->SetStyle(styles[index]);
+                    }
+                    break;
+                }
+                case DisplayListPainter::kDrawImage: {
+                    int x = reader.readInt(), y = reader.readInt(), w = reader.readInt(), h = reader.readInt();
+                    if (w < 0 || h < 0) {
+                        return false;
+                    }
+                    const unsigned char *rgba = reader.readRaw((size_t)w * h * 4);
+                    if (painter && reader.isValid()) {
+                        painter->DrawImage(x, y, w, h, rgba);
+                    }
+                    break;
+                }
+                case DisplayListPainter::kFillRects: {
+                    unsigned long rectCount = reader.readUInt32();
+                    vector<PRect> rects;
+                    for (unsigned long i = 0; i < rectCount && reader.isValid(); i++) {
+                        PRect rect;
+                        rect.mX = reader.readInt();
+                        rect.mY = reader.readInt();
+                        rect.mW = reader.readInt();
+                        rect.mH = reader.readInt();
+                        rects.push_back(rect);
+                    }
+                    if (painter && reader.isValid()) {
+                        painter->FillRects(rects.data(), (long)rects.size());
+                    }
+                    break;
+                }
+                default:
+                    return false;
+                }
+                if (!reader.isValid()) {
+                    return false;
+                }
+                count++;
+            }
+            return true;
+        }
+    }
+
+    void DisplayListPainter::writeOpcode(Opcode opcode) {
+        commands.push_back((unsigned char)opcode);
+        commandCount++;
+    }
+
+    void DisplayListPainter::writeInt(int value) {
+        appendUInt32(commands, (unsigned long)(unsigned int)value);
+    }
+
+    void DisplayListPainter::writeFloat(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        appendUInt32(commands, bits);
+    }
+
+    void DisplayListPainter::writeColor(int r, int g, int b) {
+        commands.push_back((unsigned char)r);
+        commands.push_back((unsigned char)g);
+        commands.push_back((unsigned char)b);
+    }
+
+    void DisplayListPainter::writeString(const char *inString) {
+        string text = inString ? inString : "";
+        auto found = stringIndex.find(text);
+        if (found == stringIndex.end()) {
+            found = stringIndex.emplace(text, (int)strings.size()).first;
+            strings.push_back(text);
+        }
+        appendUInt32(commands, found->second);
+    }
+
+    void DisplayListPainter::DrawLine (float inX1, float inY1, float inX2, float inY2) {
+        writeOpcode(kDrawLine);
+        writeFloat(inX1);
+        writeFloat(inY1);
+        writeFloat(inX2);
+        writeFloat(inY2);
+    }
+
+    void DisplayListPainter::FillRect (int inX, int inY, int inW, int inH) {
+        writeOpcode(kFillRect);
+        writeInt(inX);
+        writeInt(inY);
+        writeInt(inW);
+        writeInt(inH);
+    }
+
+    // one command for the whole batch, so a painter that draws a batch as
+    // one shape still does after replay
+    void DisplayListPainter::FillRects (const PRect *inRects, long inCount) {
+        writeOpcode(kFillRects);
+        appendUInt32(commands, (unsigned long)inCount);
+        for (long i = 0; i < inCount; i++) {
+            writeInt((int)inRects[i].mX);
+            writeInt((int)inRects[i].mY);
+            writeInt((int)inRects[i].mW);
+            writeInt((int)inRects[i].mH);
+        }
+    }
+
+    void DisplayListPainter::InvertRect (int inX, int inY, int inW, int inH) {
+        writeOpcode(kInvertRect);
+        writeInt(inX);
+        writeInt(inY);
+        writeInt(inW);
+        writeInt(inH);
+    }
+
+    void DisplayListPainter::SetClipRect (int inX, int inY, int inW, int inH) {
+        writeOpcode(kSetClipRect);
+        writeInt(inX);
+        writeInt(inY);
+        writeInt(inW);
+        writeInt(inH);
+    }
+
+    void DisplayListPainter::SetLineColor (int inR, int inG, int inB) {
+        writeOpcode(kSetLineColor);
+        writeColor(inR, inG, inB);
+    }
+
+    void DisplayListPainter::SetFillColor (int inR, int inG, int inB) {
+        writeOpcode(kSetFillColor);
+        writeColor(inR, inG, inB);
+    }
+
+    void DisplayListPainter::DrawText (int inX, int inY, const char *inString) {
+        writeOpcode(kDrawText);
+        writeInt(inX);
+        writeInt(inY);
+        writeString(inString);
+    }
+
+    void DisplayListPainter::DrawRotatedText (int inX, int inY, float inDegrees, const char *inString) {
+        writeOpcode(kDrawRotatedText);
+        writeInt(inX);
+        writeInt(inY);
+        writeFloat(inDegrees);
+        writeString(inString);
+    }
+
+    void DisplayListPainter::SetStyle (const PStyle &inStyle) {
+        measure.SetStyle(inStyle);
+        string encoded = encodeStyle(inStyle);
+        auto found = styleIndex.find(encoded);
+        if (found == styleIndex.end()) {
+            found = styleIndex.emplace(encoded, (int)styles.size()).first;
+            encodedStyles.push_back(encoded);
+            styles.push_back(inStyle);
+        }
+        writeOpcode(kSetStyle);
+        appendUInt32(commands, found->second);
+    }
+
+    bool DisplayListPainter::DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA) {
+        if (inW < 0 || inH < 0 || !inRGBA || !measure.CanDrawImage()) {
+            return false;
+        }
+        writeOpcode(kDrawImage);
+        writeInt(inX);
+        writeInt(inY);
+        writeInt(inW);
+        writeInt(inH);
+        commands.insert(commands.end(), inRGBA, inRGBA + (size_t)inW * inH * 4);
+        return true;
+    }
+
+    void DisplayListPainter::replay(Painter &painter) const {
+        long count;
+        runCommands(commands, strings, styles, &painter, count);
+    }
+
+    void DisplayListPainter::clear() {
+        commands.clear();
+        commandCount = 0;
+        strings.clear();
+        stringIndex.clear();
+        encodedStyles.clear();
+        styles.clear();
+        styleIndex.clear();
+    }
+
+    size_t DisplayListPainter::getByteSize() const {
+        size_t size = commands.size();
+        for (const string &text : strings) {
+            size += text.size() + 4;
+        }
+        for (const string &encoded : encodedStyles) {
+            size += encoded.size() + 4;
+        }
+        return size;
+    }
+
+    bool DisplayListPainter::writeFile(const string &filePath) const {
+        vector<unsigned char> out(kMagic, kMagic + sizeof(kMagic));
+        appendUInt32(out, strings.size());
+        for (const string &text : strings) {
+            appendBytes(out, text);
+        }
+        appendUInt32(out, encodedStyles.size());
+        for (const string &encoded : encodedStyles) {
+            appendBytes(out, encoded);
+        }
+        out.insert(out.end(), commands.begin(), commands.end());
+        ofstream file(filePath, ios::binary);
+        file.write((const char *)out.data(), out.size());
+        return (bool)file;
+    }
+
+    bool DisplayListPainter::readFile(const string &filePath) {
+        ifstream file(filePath, ios::binary);
+        if (!file) {
+            return false;
+        }
+        vector<unsigned char> in((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        if (in.size() < sizeof(kMagic) || memcmp(in.data(), kMagic, sizeof(kMagic)) != 0) {
+            return false;
+        }
+        Reader reader(in.data() + sizeof(kMagic), in.size() - sizeof(kMagic));
+        vector<string> newStrings;
+        for (unsigned long count = reader.readUInt32(), i = 0; i < count && reader.isValid(); i++) {
+            newStrings.push_back(reader.readBytes());
+        }
+        vector<string> newEncodedStyles;
+        vector<PStyle> newStyles;
+        for (unsigned long count = reader.readUInt32(), i = 0; i < count && reader.isValid(); i++) {
+            newEncodedStyles.push_back(reader.readBytes());
+            newStyles.push_back(PStyle());
+            if (!decodeStyle(newEncodedStyles.back(), newStyles.back())) {
+                return false;
+            }
+        }
+        if (!reader.isValid()) {
+            return false;
+        }
+        vector<unsigned char> newCommands(in.begin() + sizeof(kMagic) + reader.position(), in.end());
+        long newCount;
+        if (!runCommands(newCommands, newStrings, newStyles, nullptr, newCount)) {
+            return false;
+        }
+
+        clear();
+        commands.swap(newCommands);
+        commandCount = newCount;
+        strings.swap(newStrings);
+        for (size_t i = 0; i < strings.size(); i++) {
+            stringIndex.emplace(strings[i], (int)i);
+        }
+        encodedStyles.swap(newEncodedStyles);
+        styles.swap(newStyles);
+        for (size_t i = 0; i < encodedStyles.size(); i++) {
+            styleIndex.emplace(encodedStyles[i], (int)i);
+        }
+        return true;
+    }
+}
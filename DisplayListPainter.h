@@ -0,0 +1,109 @@
+//
+//  DisplayListPainter.h
+//
+//  A PPlot Painter Subclass that records the painter calls
+//  into a compact binary command list, which can be replayed
+//  into any other painter or saved to a file.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef DisplayListPainter_h
+#define DisplayListPainter_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PPlot.h"
+
+namespace SVGChart {
+    using namespace std;
+
+    // Each command is a one byte opcode followed by its arguments: coordinates
+    // as 4 byte ints or floats, colors as 3 bytes, strings and styles as 4 byte
+    // indices into tables where each distinct one is stored once, images inline.
+    // Text is measured with the measuring painter while recording, so a list
+    // is laid out for it; replay into painters with the same metrics (e.g.
+    // SVGPainters of the same size and font). Painters of different kinds
+    // measure differently: an SVGPainter uses TextMetrics plus padding, a
+    // PNGPainter its fixed glyph advance, so a list recorded against one
+    // is laid out wrong for the other.
+    class DisplayListPainter: public Painter {
+    public:
+        enum Opcode {
+            kDrawLine, kFillRect, kInvertRect, kSetClipRect, kSetLineColor, kSetFillColor,
+            kDrawText, kDrawRotatedText, kSetStyle, kDrawImage, kFillRects, kOpcodeCount
+        };
+
+        // measure answers size and text queries and gets the SetStyle calls,
+        // which may change its font; it must outlive this object
+        DisplayListPainter(Painter &measure): measure(measure) {}
+        // Overidden member functions
+        virtual void DrawLine (float inX1, float inY1, float inX2, float inY2);
+        virtual void FillRect (int inX, int inY, int inW, int inH);
+        virtual void FillRects (const PRect *inRects, long inCount);
+        virtual void InvertRect (int inX, int inY, int inW, int inH);
+        virtual void SetClipRect (int inX, int inY, int inW, int inH);
+        virtual long GetWidth () const { return measure.GetWidth(); }
+        virtual long GetHeight () const { return measure.GetHeight(); }
+        virtual void SetLineColor (int inR, int inG, int inB);
+        virtual void SetFillColor (int inR, int inG, int inB);
+        virtual long CalculateTextDrawSize (const char *inString) { return measure.CalculateTextDrawSize(inString); }
+        virtual long GetFontHeight () const { return measure.GetFontHeight(); }
+        virtual void DrawText (int inX, int inY, const char *inString);
+        virtual void DrawRotatedText (int inX, int inY, float inDegrees, const char *inString);
+        virtual void SetStyle (const PStyle &inStyle);
+        // recorded only if measure can draw images, otherwise false, so the
+        // caller records its fallback instead
+        virtual bool DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA);
+        virtual bool CanDrawImage () const { return measure.CanDrawImage(); }
+        virtual long GetOutputSize () { return (long)getByteSize(); }
+
+        // issues the recorded calls, in order, on painter
+        void replay(Painter &painter) const;
+        void clear();
+        long getCommandCount() const { return commandCount; }
+        // commands plus string and style tables
+        size_t getByteSize() const;
+        bool writeFile(const string &filePath) const;
+        // replaces the recorded commands; false if the file is not a valid list
+        bool readFile(const string &filePath);
+
+    private:
+        void writeOpcode(Opcode opcode);
+        void writeInt(int value);
+        void writeFloat(float value);
+        void writeColor(int r, int g, int b);
+        void writeString(const char *inString);
+        // private member variables
+        Painter &measure;
+        vector<unsigned char> commands;
+        long commandCount = 0;
+        vector<string> strings;
+        unordered_map<string, int> stringIndex;
+        vector<string> encodedStyles; // as written to files
+        vector<PStyle> styles;
+        unordered_map<string, int> styleIndex; // by encoded style
+
+    };
+
+}
+
+
+#endif /* DisplayListPainter_h */
@@ -26,6 +26,11 @@
 
 #include "PPlot.h"
 #include "SVGPainter.h"
+#include "GoldenCompare.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -105,8 +110,8 @@ float *readCityTemperatures(string fileName, int startLine, int endLine)  {
 }
 
 // Draw a chart showing the average temperatures
-// for each city in "AvgTempChart.svg"
-static void drawAvgTempChart(string city1Name, string city2Name, int startYear, int numYears, float *city1Data, float *city2Data) {
+// for each city into painter
+static void drawAvgTempChart(string city1Name, string city2Name, int startYear, int numYears, float *city1Data, float *city2Data, SVGPainter &painter) {
     PPlot pplot;
     pplot.mPlotBackground.mTitle = "Average Temperature";
     PlotData *theX1 = new PlotData ();
@@ -155,19 +160,42 @@ static void drawAvgTempChart(string city1Name, string city2Name, int startYear,
     pplot.mYAxisSetup.mMin = 0;
     pplot.mYAxisSetup.mMax = 100;
     pplot.mYAxisSetup.mLabel = "Temperature (F)";
-    SVGPainter painter(800, 600);
     pplot.Draw(painter);
-    painter.writeFile("AvgTempChart.svg");
 }
 
-// Test all code and draw charts.
-int main() {
+// Test all code and draw charts. With --check [--tolerance T] the chart is
+// compared with the checked in AvgTempChart.svg instead of written.
+int main(int argc, char *argv[]) {
+    bool check = argc > 1 && strcmp(argv[1], "--check") == 0;
+    double tolerance = 0;
+    for (int i = 2; check && i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--tolerance") == 0) {
+            tolerance = atof(argv[i + 1]);
+        }
+    }
     // draw graphs
     float *nycData = readCityTemperatures("tempdata.csv", 1, 51);
     float *burlingtonData = readCityTemperatures("tempdata.csv", 52, 102);
-    drawAvgTempChart("NYC, NY", "Burlington, VT", 1968, 51, nycData, burlingtonData);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    SVGPainter painter(800, 600);
+    drawAvgTempChart("NYC, NY", "Burlington, VT", 1968, 51, nycData, burlingtonData, painter);
+    double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
     delete[] nycData;
     delete[] burlingtonData;
-    return 0;
+    if (!check) {
+        painter.writeFile("AvgTempChart.svg");
+        return 0;
+    }
+    ifstream goldenFile("AvgTempChart.svg");
+    stringstream golden;
+    golden << goldenFile.rdbuf();
+    string difference = "cannot read AvgTempChart.svg";
+    bool same = goldenFile && compareSVG(golden.str(), painter.getContent(), tolerance, difference);
+    cout << (same ? "ok   " : "FAIL ") << "AvgTempChart.svg " << milliseconds << " ms";
+    if (!same) {
+        cout << "  " << difference;
+    }
+    cout << endl;
+    return same ? 0 : 1;
 }
 
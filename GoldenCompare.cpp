@@ -0,0 +1,105 @@
+//
+//  GoldenCompare.cpp
+//
+//  Compares rendered charts with checked in golden files, for the
+//  --check modes of the test and example programs.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "GoldenCompare.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+namespace SVGChart {
+    using namespace std;
+
+    namespace {
+        // a number starts here, and isn't the tail of a name like clip12 or #a0b0c0
+        bool isNumberStart(const string &text, size_t pos) {
+            if (pos > 0) {
+                char before = text[pos - 1];
+                if (isalnum((unsigned char)before) || before == '_' || before == '#' || before == '.') {
+                    return false;
+                }
+            }
+            size_t digit = pos;
+            if (digit < text.size() && (text[digit] == '-' || text[digit] == '+')) {
+                digit++;
+            }
+            if (digit < text.size() && text[digit] == '.') {
+                digit++;
+            }
+            return digit < text.size() && isdigit((unsigned char)text[digit]);
+        }
+
+        string describeDifference(const string &expected, const string &actual, size_t expectedPos, size_t actualPos) {
+            long line = 1 + count(expected.begin(), expected.begin() + min(expectedPos, expected.size()), '\n');
+            size_t expectedStart = expectedPos > 20 ? expectedPos - 20 : 0;
+            size_t actualStart = actualPos > 20 ? actualPos - 20 : 0;
+            string expectedSnippet = expected.substr(min(expectedStart, expected.size()), 50);
+            string actualSnippet = actual.substr(min(actualStart, actual.size()), 50);
+            replace(expectedSnippet.begin(), expectedSnippet.end(), '\n', ' ');
+            replace(actualSnippet.begin(), actualSnippet.end(), '\n', ' ');
+            return "line " + to_string(line) + ": expected \"" + expectedSnippet + "\" got \"" + actualSnippet + "\"";
+        }
+    }
+
+    bool compareSVG(const string &expected, const string &actual, double tolerance, string &difference) {
+        if (expected == actual) {
+            return true;
+        }
+        size_t e = 0, a = 0;
+        if (tolerance <= 0) {
+            while (e < expected.size() && e < actual.size() && expected[e] == actual[e]) {
+                e++;
+            }
+            difference = describeDifference(expected, actual, e, e);
+            return false;
+        }
+        while (e < expected.size() && a < actual.size()) {
+            if (isNumberStart(expected, e) && isNumberStart(actual, a)) {
+                char *expectedEnd;
+                char *actualEnd;
+                double expectedValue = strtod(expected.c_str() + e, &expectedEnd);
+                double actualValue = strtod(actual.c_str() + a, &actualEnd);
+                if (fabs(expectedValue - actualValue) > tolerance) {
+                    difference = describeDifference(expected, actual, e, a);
+                    return false;
+                }
+                e = expectedEnd - expected.c_str();
+                a = actualEnd - actual.c_str();
+                continue;
+            }
+            if (expected[e] != actual[a]) {
+                difference = describeDifference(expected, actual, e, a);
+                return false;
+            }
+            e++;
+            a++;
+        }
+        if (e < expected.size() || a < actual.size()) {
+            difference = describeDifference(expected, actual, e, a);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,41 @@
+//
+//  GoldenCompare.h
+//
+//  Compares rendered charts with checked in golden files, for the
+//  --check modes of the test and example programs.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef GoldenCompare_h
+#define GoldenCompare_h
+
+#include <string>
+
+namespace SVGChart {
+    using namespace std;
+
+    // Compares two SVG documents. With a tolerance of 0 they must be byte
+    // identical. Otherwise numbers may differ by up to tolerance and only the
+    // text between them must match, so changes in coordinate formatting
+    // ("12" vs "12.0001") pass. On a mismatch difference describes the first one.
+    bool compareSVG(const string &expected, const string &actual, double tolerance, string &difference);
+}
+
+#endif /* GoldenCompare_h */
@@ -0,0 +1,260 @@
+//
+//  PNGEncoder.cpp
+//
+//  A minimal, dependency free PNG encoder used by the raster
+//  painters.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "PNGEncoder.h"
+#include <cstring>
+
+namespace SVGChart {
+    using namespace std;
+
+    namespace {
+        const int kWindowSize = 32768;
+        const int kMinMatch = 3;
+        const int kMaxMatch = 258;
+        const int kHashBits = 15;
+        const int kMaxChain = 32;
+
+        const int kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        const int kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        const int kDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        const int kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        // Deflate streams are packed least significant bit first.
+        class BitWriter {
+        public:
+            BitWriter(vector<unsigned char> &out): out(out) {}
+
+            void writeBits(unsigned int value, int count) {
+                bitBuffer |= value << bitCount;
+                bitCount += count;
+                while (bitCount >= 8) {
+                    out.push_back((unsigned char)(bitBuffer & 0xFF));
+                    bitBuffer >>= 8;
+                    bitCount -= 8;
+                }
+            }
+
+            // Huffman codes are defined most significant bit first.
+            void writeCode(unsigned int code, int length) {
+                unsigned int reversed = 0;
+                for (int i = 0; i < length; i++) {
+                    reversed = (reversed << 1) | ((code >> i) & 1);
+                }
+                writeBits(reversed, length);
+            }
+
+            void flush() {
+                if (bitCount > 0) {
+                    out.push_back((unsigned char)(bitBuffer & 0xFF));
+                }
+                bitBuffer = 0;
+                bitCount = 0;
+            }
+
+        private:
+            vector<unsigned char> &out;
+            unsigned int bitBuffer = 0;
+            int bitCount = 0;
+        };
+
+        void writeLiteral(BitWriter &writer, int symbol) {
+            if (symbol < 144) {
+                writer.writeCode(0x30 + symbol, 8);
+            } else if (symbol < 256) {
+                writer.writeCode(0x190 + symbol - 144, 9);
+            } else if (symbol < 280) {
+                writer.writeCode(symbol - 256, 7);
+            } else {
+                writer.writeCode(0xC0 + symbol - 280, 8);
+            }
+        }
+
+        void writeMatch(BitWriter &writer, int length, int distance) {
+            int lengthCode = 28;
+            while (kLengthBase[lengthCode] > length) {
+                lengthCode--;
+            }
+            writeLiteral(writer, 257 + lengthCode);
+            writer.writeBits(length - kLengthBase[lengthCode], kLengthExtra[lengthCode]);
+
+            int distCode = 29;
+            while (kDistBase[distCode] > distance) {
+                distCode--;
+            }
+            writer.writeCode(distCode, 5);
+            writer.writeBits(distance - kDistBase[distCode], kDistExtra[distCode]);
+        }
+
+        unsigned int hash3(const unsigned char *p) {
+            unsigned int h = (unsigned int)p[0] << 16 | (unsigned int)p[1] << 8 | p[2];
+            return (h * 2654435761u) >> (32 - kHashBits);
+        }
+
+        unsigned long adler32(const unsigned char *data, size_t size) {
+            unsigned long a = 1, b = 0;
+            while (size > 0) {
+                size_t chunk = size < 5552 ? size : 5552;
+                size -= chunk;
+                while (chunk-- > 0) {
+                    a += *data++;
+                    b += a;
+                }
+                a %= 65521;
+                b %= 65521;
+            }
+            return (b << 16) | a;
+        }
+
+        struct CRCTable {
+            unsigned long entries[256];
+            CRCTable() {
+                for (unsigned long n = 0; n < 256; n++) {
+                    unsigned long c = n;
+                    for (int k = 0; k < 8; k++) {
+                        c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+                    }
+                    entries[n] = c;
+                }
+            }
+        };
+
+        unsigned long crc32(const unsigned char *data, size_t size) {
+            static const CRCTable table;
+            unsigned long crc = 0xFFFFFFFFUL;
+            for (size_t i = 0; i < size; i++) {
+                crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            }
+            return crc ^ 0xFFFFFFFFUL;
+        }
+
+        void writeUInt32(vector<unsigned char> &out, unsigned long value) {
+            out.push_back((unsigned char)((value >> 24) & 0xFF));
+            out.push_back((unsigned char)((value >> 16) & 0xFF));
+            out.push_back((unsigned char)((value >> 8) & 0xFF));
+            out.push_back((unsigned char)(value & 0xFF));
+        }
+
+        void writeChunk(vector<unsigned char> &out, const char *type, const vector<unsigned char> &data) {
+            writeUInt32(out, data.size());
+            size_t start = out.size();
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data.begin(), data.end());
+            writeUInt32(out, crc32(&out[start], out.size() - start));
+        }
+    }
+
+    void ZlibCompress (const unsigned char *inData, size_t inSize, vector<unsigned char> &outData) {
+        outData.push_back(0x78);
+        outData.push_back(0x01);
+
+        BitWriter writer(outData);
+        writer.writeBits(1, 1); // final block
+        writer.writeBits(1, 2); // fixed Huffman codes
+
+        vector<int> head(1 << kHashBits, -1);
+        vector<int> prev(kWindowSize, -1);
+        size_t pos = 0;
+        while (pos < inSize) {
+            int bestLength = 0;
+            int bestDistance = 0;
+            if (pos + kMinMatch <= inSize) {
+                unsigned int h = hash3(inData + pos);
+                int candidate = head[h];
+                int chain = 0;
+                size_t maxLength = inSize - pos < (size_t)kMaxMatch ? inSize - pos : kMaxMatch;
+                while (candidate >= 0 && pos - candidate <= (size_t)kWindowSize && chain++ < kMaxChain) {
+                    const unsigned char *a = inData + candidate;
+                    const unsigned char *b = inData + pos;
+                    size_t length = 0;
+                    while (length < maxLength && a[length] == b[length]) {
+                        length++;
+                    }
+                    if ((int)length > bestLength) {
+                        bestLength = (int)length;
+                        bestDistance = (int)(pos - candidate);
+                        if (length == maxLength) {
+                            break;
+                        }
+                    }
+                    candidate = prev[candidate % kWindowSize];
+                }
+            }
+
+            size_t advance = 1;
+            if (bestLength >= kMinMatch) {
+                writeMatch(writer, bestLength, bestDistance);
+                advance = bestLength;
+            } else {
+                writeLiteral(writer, inData[pos]);
+            }
+            for (size_t i = 0; i < advance; i++, pos++) {
+                if (pos + kMinMatch <= inSize) {
+                    unsigned int h = hash3(inData + pos);
+                    prev[pos % kWindowSize] = head[h];
+                    head[h] = (int)pos;
+                }
+            }
+        }
+        writeLiteral(writer, 256); // end of block
+        writer.flush();
+
+        writeUInt32(outData, adler32(inData, inSize));
+    }
+
+    bool EncodePNG (long inWidth, long inHeight, const unsigned char *inRGBA, vector<unsigned char> &outPNG) {
+        if (inWidth <= 0 || inHeight <= 0 || !inRGBA) {
+            return false;
+        }
+
+        // every scanline is prefixed by its filter type (0, none)
+        size_t rowBytes = (size_t)inWidth * 4;
+        vector<unsigned char> raw;
+        raw.reserve((rowBytes + 1) * inHeight);
+        for (long y = 0; y < inHeight; y++) {
+            raw.push_back(0);
+            const unsigned char *row = inRGBA + y * rowBytes;
+            raw.insert(raw.end(), row, row + rowBytes);
+        }
+
+        const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+        outPNG.insert(outPNG.end(), signature, signature + 8);
+
+        vector<unsigned char> header;
+        writeUInt32(header, inWidth);
+        writeUInt32(header, inHeight);
+        header.push_back(8); // bit depth
+        header.push_back(6); // color type RGBA
+        header.push_back(0); // compression
+        header.push_back(0); // filter
+        header.push_back(0); // no interlace
+        writeChunk(outPNG, "IHDR", header);
+
+        vector<unsigned char> compressed;
+        ZlibCompress(raw.data(), raw.size(), compressed);
+        writeChunk(outPNG, "IDAT", compressed);
+        writeChunk(outPNG, "IEND", vector<unsigned char>());
+        return true;
+    }
+}
@@ -0,0 +1,44 @@
+//
+//  PNGEncoder.h
+//
+//  A minimal, dependency free PNG encoder used by the raster
+//  painters. Pixels are compressed with a fixed-Huffman deflate
+//  stream and a greedy LZ77 matcher, which is plenty for charts
+//  that are mostly flat background.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef PNGEncoder_h
+#define PNGEncoder_h
+
+#include <vector>
+
+namespace SVGChart {
+    using namespace std;
+
+    // Encodes inWidth x inHeight 8 bit RGBA pixels (row major, no padding)
+    // as a complete PNG file into outPNG. Returns false on bad dimensions.
+    bool EncodePNG (long inWidth, long inHeight, const unsigned char *inRGBA, vector<unsigned char> &outPNG);
+
+    // zlib (RFC 1950) wrapped deflate stream using fixed Huffman codes.
+    void ZlibCompress (const unsigned char *inData, size_t inSize, vector<unsigned char> &outData);
+}
+
+#endif /* PNGEncoder_h */
@@ -0,0 +1,297 @@
+//
+//  PNGPainter.cpp
+//
+//  A PPlot Painter Subclass for drawing a
+//  chart into an RGBA framebuffer and saving
+//  it as a PNG file.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "PNGPainter.h"
+#include "PNGEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace SVGChart {
+    using namespace std;
+
+    // Classic 5x7 bitmap font for the printable ASCII range (32-126).
+    // Each glyph is five columns, least significant bit at the top.
+    const unsigned char FONT_5X7[95][5] = {
+        {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7F, 0x14, 0x7F, 0x14},
+        {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00},
+        {0x00, 0x1C, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x08, 0x2A, 0x1C, 0x2A, 0x08}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+        {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},
+        {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31},
+        {0x18, 0x14, 0x12, 0x7F, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+        {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00},
+        {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06},
+        {0x32, 0x49, 0x79, 0x41, 0x3E}, {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+        {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x01, 0x01}, {0x3E, 0x41, 0x41, 0x51, 0x32},
+        {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41},
+        {0x7F, 0x40, 0x40, 0x40, 0x40}, {0x7F, 0x02, 0x04, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+        {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31},
+        {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x7F, 0x20, 0x18, 0x20, 0x7F},
+        {0x63, 0x14, 0x08, 0x14, 0x63}, {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},
+        {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},
+        {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78}, {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20},
+        {0x38, 0x44, 0x44, 0x48, 0x7F}, {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x08, 0x14, 0x54, 0x54, 0x3C},
+        {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00}, {0x00, 0x7F, 0x10, 0x28, 0x44},
+        {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78}, {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},
+        {0x7C, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+        {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C}, {0x3C, 0x40, 0x30, 0x40, 0x3C},
+        {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C}, {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},
+        {0x00, 0x00, 0x7F, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08}
+    };
+    const int GLYPH_ADVANCE = 6; // five columns plus one column of spacing
+    const int GLYPH_ROWS = 7;
+
+    PNGPainter::PNGPainter(long width, long height): pixels(width * height * 4, 0), clipX0(0), clipY0(0), clipX1(width), clipY1(height), _width(width), _height(height) {
+    }
+
+    void PNGPainter::blendPixel(long x, long y, int r, int g, int b, float coverage) {
+        if (x < clipX0 || x >= clipX1 || y < clipY0 || y >= clipY1 || coverage <= 0) {
+            return;
+        }
+        if (coverage > 1) {
+            coverage = 1;
+        }
+        unsigned char *p = &pixels[(y * _width + x) * 4];
+        float dstAlpha = p[3] / 255.0f;
+        float outAlpha = coverage + dstAlpha * (1 - coverage);
+        if (outAlpha <= 0) {
+            return;
+        }
+        // "over" compositing with non-premultiplied storage
+        float dstWeight = dstAlpha * (1 - coverage);
+        p[0] = (unsigned char)lround((r * coverage + p[0] * dstWeight) / outAlpha);
+        p[1] = (unsigned char)lround((g * coverage + p[1] * dstWeight) / outAlpha);
+        p[2] = (unsigned char)lround((b * coverage + p[2] * dstWeight) / outAlpha);
+        p[3] = (unsigned char)lround(outAlpha * 255);
+    }
+
+    // Xiaolin Wu's antialiased line; only the part of the major axis
+    // inside the clip rectangle is walked, so off-screen lines are cheap.
+    void PNGPainter::DrawLine (float inX1, float inY1, float inX2, float inY2) {
+        // pixel centers sit at half coordinates
+        float x0 = inX1 - 0.5f, y0 = inY1 - 0.5f, x1 = inX2 - 0.5f, y1 = inY2 - 0.5f;
+        if ((x0 < clipX0 - 1 && x1 < clipX0 - 1) || (x0 > clipX1 && x1 > clipX1) ||
+            (y0 < clipY0 - 1 && y1 < clipY0 - 1) || (y0 > clipY1 && y1 > clipY1)) {
+            return;
+        }
+
+        bool steep = fabs(y1 - y0) > fabs(x1 - x0);
+        if (steep) {
+            swap(x0, y0);
+            swap(x1, y1);
+        }
+        if (x0 > x1) {
+            swap(x0, x1);
+            swap(y0, y1);
+        }
+        auto plot = [&](long major, long minor, float coverage) {
+            if (steep) {
+                blendPixel(minor, major, lineRed, lineGreen, lineBlue, coverage);
+            } else {
+                blendPixel(major, minor, lineRed, lineGreen, lineBlue, coverage);
+            }
+        };
+        float dx = x1 - x0;
+        float gradient = dx == 0 ? 1 : (y1 - y0) / dx;
+
+        // first endpoint
+        float xEnd = roundf(x0);
+        float yEnd = y0 + gradient * (xEnd - x0);
+        float xGap = 1 - (x0 + 0.5f - floorf(x0 + 0.5f));
+        long xPixel1 = (long)xEnd;
+        float yFloor = floorf(yEnd);
+        plot(xPixel1, (long)yFloor, (1 - (yEnd - yFloor)) * xGap);
+        plot(xPixel1, (long)yFloor + 1, (yEnd - yFloor) * xGap);
+        float interY = yEnd + gradient;
+
+        // second endpoint
+        xEnd = roundf(x1);
+        yEnd = y1 + gradient * (xEnd - x1);
+        xGap = x1 + 0.5f - floorf(x1 + 0.5f);
+        long xPixel2 = (long)xEnd;
+        if (xPixel2 != xPixel1) {
+            yFloor = floorf(yEnd);
+            plot(xPixel2, (long)yFloor, (1 - (yEnd - yFloor)) * xGap);
+            plot(xPixel2, (long)yFloor + 1, (yEnd - yFloor) * xGap);
+        }
+
+        // main loop, limited to the visible span of the major axis
+        long majorMin = steep ? clipY0 : clipX0;
+        long majorMax = steep ? clipY1 : clipX1;
+        long first = max(xPixel1 + 1, majorMin);
+        long last = min(xPixel2 - 1, majorMax);
+        interY += gradient * (first - (xPixel1 + 1));
+        for (long x = first; x <= last; x++) {
+            float iFloor = floorf(interY);
+            plot(x, (long)iFloor, 1 - (interY - iFloor));
+            plot(x, (long)iFloor + 1, interY - iFloor);
+            interY += gradient;
+        }
+    }
+
+    void PNGPainter::FillRect (int inX, int inY, int inW, int inH) {
+        if (inW < 0) {
+            inX += inW;
+            inW = -inW;
+        }
+        if (inH < 0) {
+            inY += inH;
+            inH = -inH;
+        }
+        long x0 = max((long)inX, clipX0), x1 = min((long)inX + inW, clipX1);
+        long y0 = max((long)inY, clipY0), y1 = min((long)inY + inH, clipY1);
+        if (x0 >= x1 || y0 >= y1) {
+            return;
+        }
+        for (long y = y0; y < y1; y++) {
+            unsigned char *p = &pixels[(y * _width + x0) * 4];
+            for (long x = x0; x < x1; x++, p += 4) {
+                p[0] = (unsigned char)fillRed;
+                p[1] = (unsigned char)fillGreen;
+                p[2] = (unsigned char)fillBlue;
+                p[3] = 255;
+            }
+        }
+    }
+
+    // Matches SVGPainter: a translucent overlay in the fill color.
+    void PNGPainter::InvertRect (int inX, int inY, int inW, int inH) {
+        if (inW < 0) {
+            inX += inW;
+            inW = -inW;
+        }
+        if (inH < 0) {
+            inY += inH;
+            inH = -inH;
+        }
+        long x0 = max((long)inX, clipX0), x1 = min((long)inX + inW, clipX1);
+        long y0 = max((long)inY, clipY0), y1 = min((long)inY + inH, clipY1);
+        for (long y = y0; y < y1; y++) {
+            for (long x = x0; x < x1; x++) {
+                blendPixel(x, y, fillRed, fillGreen, fillBlue, 0.2f);
+            }
+        }
+    }
+
+    void PNGPainter::SetClipRect (int inX, int inY, int inW, int inH) {
+        clipX0 = max(0L, (long)inX);
+        clipY0 = max(0L, (long)inY);
+        clipX1 = min(_width, (long)inX + inW);
+        clipY1 = min(_height, (long)inY + inH);
+    }
+
+    int PNGPainter::glyphScale() const {
+        return max(1, (fontSize + 4) / 8);
+    }
+
+    long PNGPainter::CalculateTextDrawSize (const char *inString) {
+        return long(strlen(inString) * GLYPH_ADVANCE * glyphScale());
+    }
+
+    // Renders by inverse mapping each destination pixel into the
+    // unrotated glyph grid, so rotated text has no holes.
+    void PNGPainter::drawString(int inX, int inY, float inDegrees, const char *inString) {
+        int scale = glyphScale();
+        long length = strlen(inString);
+        float textW = length * GLYPH_ADVANCE * scale;
+        float textTop = -GLYPH_ROWS * scale; // baseline at y = 0
+        float radians = inDegrees * 3.14159265f / 180.0f;
+        float c = cosf(radians), s = sinf(radians);
+
+        float minX = 0, maxX = 0, minY = 0, maxY = 0;
+        const float cornersX[4] = {0, textW, 0, textW};
+        const float cornersY[4] = {textTop, textTop, 0, 0};
+        for (int i = 0; i < 4; i++) {
+            float rx = cornersX[i] * c - cornersY[i] * s;
+            float ry = cornersX[i] * s + cornersY[i] * c;
+            minX = i == 0 ? rx : min(minX, rx);
+            maxX = i == 0 ? rx : max(maxX, rx);
+            minY = i == 0 ? ry : min(minY, ry);
+            maxY = i == 0 ? ry : max(maxY, ry);
+        }
+        long px0 = max(clipX0, (long)floorf(inX + minX));
+        long px1 = min(clipX1, (long)ceilf(inX + maxX));
+        long py0 = max(clipY0, (long)floorf(inY + minY));
+        long py1 = min(clipY1, (long)ceilf(inY + maxY));
+        for (long py = py0; py < py1; py++) {
+            for (long px = px0; px < px1; px++) {
+                float dx = px + 0.5f - inX, dy = py + 0.5f - inY;
+                float lx = dx * c + dy * s;
+                float ly = -dx * s + dy * c;
+                if (lx < 0 || lx >= textW || ly < textTop || ly >= 0) {
+                    continue;
+                }
+                long column = (long)(lx / scale);
+                long row = (long)((ly - textTop) / scale);
+                long glyph = column / GLYPH_ADVANCE;
+                long glyphColumn = column % GLYPH_ADVANCE;
+                unsigned char ch = (unsigned char)inString[glyph];
+                if (glyphColumn >= 5 || ch < 32 || ch > 126) {
+                    continue;
+                }
+                if (FONT_5X7[ch - 32][glyphColumn] & (1 << row)) {
+                    blendPixel(px, py, lineRed, lineGreen, lineBlue, 1);
+                }
+            }
+        }
+    }
+
+    void PNGPainter::DrawText (int inX, int inY, const char *inString) {
+        drawString(inX, inY, 0, inString);
+    }
+
+    void PNGPainter::DrawRotatedText (int inX, int inY, float inDegrees, const char *inString) {
+        drawString(inX, inY, inDegrees, inString);
+    }
+
+    bool PNGPainter::DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA) {
+        for (long y = 0; y < inH; y++) {
+            const unsigned char *row = inRGBA + y * inW * 4;
+            for (long x = 0; x < inW; x++) {
+                const unsigned char *p = row + x * 4;
+                if (p[3] > 0) {
+                    blendPixel(inX + x, inY + y, p[0], p[1], p[2], p[3] / 255.0f);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool PNGPainter::encode(vector<unsigned char> &png) const {
+        return EncodePNG(_width, _height, pixels.data(), png);
+    }
+
+    bool PNGPainter::writeFile(const string &filePath) const {
+        vector<unsigned char> png;
+        if (!encode(png)) {
+            return false;
+        }
+        ofstream outFile(filePath, ios::binary);
+        outFile.write((const char *)png.data(), png.size());
+        return (bool)outFile;
+    }
+}
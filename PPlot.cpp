@@ -36,10 +36,16 @@
 #include "PPlot.h"
 
 #include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <thread>
+#include <typeinfo>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 // --- #include <stdlib.h>
 #include <assert.h>
+#include <limits.h>
 
 namespace SVGChart {
 
@@ -52,6 +58,7 @@ namespace SVGChart {
     const float kExpMax = 1e10f;// max argument for pow10 function
     const float kLogMinClipValue = 1e-10f;// pragmatism to avoid problems with small values in log plot
     const float kEps = 1e-4f;
+    const float kPi = 3.14159265f;
     const float kRelMajorTickSize = 0.02f;
     const float kRelMinorTickSize = 0.01f;
     const int kMinMinorTickScreenSize = 1;// minor ticks should not become smaller than this
@@ -60,6 +67,7 @@ namespace SVGChart {
     const float kLittleDecrease = 0.9999f;
     const float kTickValueVeryBig = 1.0e4;// switch to scientific format
     const float kTickValueVerySmall = (float)1.0e-3;
+    const double kTickIndexTolerance = 1.0e-4;// fraction of a tick step that still counts as on the axis
     const float kMajorTickXInitialFac = 2.0f;
     const float kMajorTickYInitialFac = 3.0f;
     const PMargins kDefaultMargins = PMargins (40,20,5,42);
@@ -109,6 +117,29 @@ namespace SVGChart {
       return 0;
     }
 
+    PlotDataSpan PlotDataBase::GetSpan () const {
+      PlotDataSpan theSpan;
+      const RealPlotData *theData = GetRealPlotData ();
+      if (theData) {
+        theSpan.mData = theData->data ();
+        theSpan.mSize = theData->size ();
+        return theSpan;
+      }
+      const CalculatedDataBase *theCalculated = GetCalculatedData ();
+      if (theCalculated) {
+        theSpan.mSize = theCalculated->GetSize ();
+        if (typeid (*theCalculated) == typeid (CalculatedData)) {
+          const CalculatedData *theAffine = static_cast<const CalculatedData *> (theCalculated);
+          theSpan.mOffset = theAffine->mMin;
+          theSpan.mDelta = theAffine->mDelta;
+        }
+        else {
+          theSpan.mCalculated = theCalculated;
+        }
+      }
+      return theSpan;
+    }
+
     bool PlotDataBase::CalculateRange (float &outXMin, float &outXMax) {
       const RealPlotData *theData = GetRealPlotData ();
       if (theData && theData->size () >0) {
@@ -130,6 +161,91 @@ namespace SVGChart {
       return false;
     }
 
+    string ElideText (const string &inText, long inMaxWidth, ElideMode inMode, Painter &inPainter) {
+      if (inText.empty () || inPainter.CalculateTextDrawSize (inText.c_str ()) < inMaxWidth) {
+        return inText;
+      }
+      // candidate cut points, at utf-8 character boundaries only
+      vector<size_t> theBounds;
+      for (size_t theI=0; theI<inText.size (); theI++) {
+        if ((inText[theI] & 0xC0) != 0x80) {
+          theBounds.push_back (theI);
+        }
+      }
+      long theCount = theBounds.size ();
+      theBounds.push_back (inText.size ());
+
+      // elided text keeping inKeep characters; longer versions are never narrower
+      auto theElided = [&] (long inKeep) {
+        long theHead = 0;
+        if (inMode == kElideEnd) {
+          theHead = inKeep;
+        }
+        else if (inMode == kElideMiddle) {
+          theHead = (inKeep+1)/2;
+        }
+        long theTail = inKeep-theHead;
+        return inText.substr (0, theBounds[theHead]) + "..." + inText.substr (theBounds[theCount-theTail]);
+      };
+
+      long theLow = 0;// always used, even if "..." alone does not fit
+      long theHigh = theCount-1;
+      while (theLow < theHigh) {
+        long theMid = (theLow+theHigh+1)/2;
+        if (inPainter.CalculateTextDrawSize (theElided (theMid).c_str ()) < inMaxWidth) {
+          theLow = theMid;
+        }
+        else {
+          theHigh = theMid-1;
+        }
+      }
+      return theElided (theLow);
+    }
+
+    bool ClipLine (float &ioX1, float &ioY1, float &ioX2, float &ioY2, const PRect &inRect) {
+      float theDX = ioX2-ioX1;
+      float theDY = ioY2-ioY1;
+      const float theP[4] = {-theDX, theDX, -theDY, theDY};
+      const float theQ[4] = {ioX1-inRect.mX, inRect.mX+inRect.mW-ioX1, ioY1-inRect.mY, inRect.mY+inRect.mH-ioY1};
+      float theT0 = 0;
+      float theT1 = 1;
+      for (int theI=0;theI<4;theI++) {
+        if (theP[theI] == 0) {
+          if (theQ[theI] < 0) {
+            return false;// parallel to and outside this edge
+          }
+          continue;
+        }
+        float theT = theQ[theI]/theP[theI];
+        if (theP[theI] < 0) {
+          if (theT > theT1) {
+            return false;
+          }
+          theT0 = PMax (theT0, theT);
+        }
+        else {
+          if (theT < theT0) {
+            return false;
+          }
+          theT1 = PMin (theT1, theT);
+        }
+      }
+      // NaN coordinates fail every comparison above, reject them here, and
+      // segments that only touch the rect, clipped down to a single point
+      if (!(theT0 < theT1)) {
+        return false;
+      }
+      if (theT1 < 1) {
+        ioX2 = ioX1+theT1*theDX;
+        ioY2 = ioY1+theT1*theDY;
+      }
+      if (theT0 > 0) {
+        ioX1 = ioX1+theT0*theDX;
+        ioY1 = ioY1+theT0*theDY;
+      }
+      return true;
+    }
+
     DummyData::DummyData (long inSize) {
       for (int theI=0;theI<inSize;theI++) {
         mRealPlotData.push_back (theI);// simple ascending data
@@ -277,28 +393,69 @@ namespace SVGChart {
     }
 
     void TickInfo::MakeFormatString (float inValue, string &outFormatString) {
+      outFormatString = GetFormatString (inValue);
+    }
+
+    const char * TickInfo::GetFormatString (float inValue) {
+      static const char * const kFixedFormats[] = {"%.0f", "%.1f", "%.2f", "%.3f", "%.4f", "%.5f", "%.6f", "%.7f", "%.8f", "%.9f"};
       if (inValue<0) {
         inValue = - inValue;
       }
-      if (inValue > kTickValueVeryBig || inValue < kTickValueVerySmall) {
-        outFormatString = "%.1e";
+      // tolerate float noise, 0.01 may come in as 0.0099999998
+      if (inValue > kTickValueVeryBig || inValue < kTickValueVerySmall*kLittleDecrease) {
+        return "%.1e";
       }
-      else {
 
-        int thePrecision = 0;
-        if (inValue<1) {
-          float theSpan = inValue;
-          while (theSpan<1) {
-        thePrecision++;
-        theSpan *=10;
-          }
+      int thePrecision = 0;
+      if (inValue<kLittleDecrease) {
+        float theSpan = inValue;
+        while (theSpan<kLittleDecrease && thePrecision<9) {
+          thePrecision++;
+          theSpan *=10;
         }
+      }
+      return kFixedFormats[thePrecision];
+    }
+
+    int TickInfo::FormatLabel (float inValue, const char *inFormatString, char *outBuf, int inBufSize) {
+      // "%.Nf" and "%.Ne": std::to_chars formats exactly like printf, without parsing a format at runtime
+      const char *theFormat = inFormatString;
+      if (theFormat[0] == '%' && theFormat[1] == '.' && theFormat[2] >= '0' && theFormat[2] <= '9' &&
+          (theFormat[3] == 'f' || theFormat[3] == 'e') && theFormat[4] == 0) {
+        std::chars_format theStyle = theFormat[3] == 'f' ? std::chars_format::fixed : std::chars_format::scientific;
+        std::to_chars_result theResult = std::to_chars (outBuf, outBuf+inBufSize-1, (double)inValue, theStyle, theFormat[2]-'0');
+        if (theResult.ec == std::errc ()) {
+          *theResult.ptr = 0;
+          return theResult.ptr-outBuf;
+        }
+      }
+      int theLength = snprintf (outBuf, inBufSize, inFormatString, inValue);
+      return PMax (0, PMin (theLength, inBufSize-1));
+    }
 
-        char theBuf[128] = "%.0f";
-        theBuf[2] = '0'+thePrecision;
+    void TickList::AddTick (float inValue, bool inIsMajor, const char *inLabel, int inLength) {
+      mTicks.push_back ({inValue, inIsMajor, (long)mLabels.size ()});
+      mLabels.insert (mLabels.end (), inLabel, inLabel+inLength);
+      mLabels.push_back (0);
+    }
 
-        outFormatString = theBuf;
+    bool TickIterator::FillTicks (TickList &outTickList) {
+      outTickList.Clear ();
+      if (!Init ()) {
+        return false;
       }
+      float theTick;
+      bool theIsMajorTick;
+      string theFormatString;
+      char theBuf[128];
+      while (GetNextTick (theTick, theIsMajorTick, theFormatString)) {
+        int theLength = 0;
+        if (theIsMajorTick) {
+          theLength = TickInfo::FormatLabel (theTick, theFormatString.c_str (), theBuf, sizeof (theBuf));
+        }
+        outTickList.AddTick (theTick, theIsMajorTick, theBuf, theLength);
+      }
+      return true;
     }
 
     PlotDataBase::~PlotDataBase (){
@@ -404,6 +561,7 @@ namespace SVGChart {
         mLegendDataList.erase (theLI);
         mDataDrawerList.erase (theDI);
         mPlotDataSelectionList.erase (thePI);
+        mGeneration++;
     }
 
     void PlotDataContainer::ClearData () {
@@ -437,6 +595,7 @@ namespace SVGChart {
       mLegendDataList.clear ();
       mDataDrawerList.clear ();
       mPlotDataSelectionList.clear ();
+      mGeneration++;
     }
 
     void PlotDataContainer::AddXYPlot (PlotDataBase *inXData, PlotDataBase *inYData, LegendData *inLegendData, DataDrawerBase *inDataDrawer, PlotDataSelection *inPlotDataSelection) {
@@ -471,6 +630,7 @@ namespace SVGChart {
         thePlotDataSelection->resize (inYData->GetSize ());
       }
       mPlotDataSelectionList.push_back (thePlotDataSelection);
+      mGeneration++;
     }
 
     void PlotDataContainer::SetXYPlot (int inIndex, PlotDataBase *inXData, PlotDataBase *inYData, LegendData *inLegendData, DataDrawerBase *inDataDrawer, PlotDataSelection *inPlotDataSelection) {
@@ -527,6 +687,7 @@ namespace SVGChart {
             mDataDrawerList.push_back (theDataDrawer);
             mPlotDataSelectionList.push_back (thePlotDataSelection);
         }
+        mGeneration++;
     }
 
     bool PlotDataContainer::SetDataDrawer (int inIndex, DataDrawerBase* inDataDrawer) {
@@ -539,6 +700,7 @@ namespace SVGChart {
         }
         delete mDataDrawerList[inIndex];
         mDataDrawerList[inIndex] = theDataDrawer;
+        mGeneration++;
         return true;
     }
 
@@ -632,13 +794,15 @@ namespace SVGChart {
         // bool theEnteredXRange = false;
         bool initialized = false;
         
-        if (inXData.GetSize () != inYData.GetSize ()) {
+        PlotDataSpan theXSpan = inXData.GetSpan ();
+        PlotDataSpan theYSpan = inYData.GetSpan ();
+        if (theXSpan.GetSize () != theYSpan.GetSize ()) {
             return false;
         }
 
-        for (long theI = 0; theI < inXData.GetSize (); theI++) {
-            float theX = inXData.GetValue (theI);
-            float theY = inYData.GetValue (theI);
+        for (long theI = 0; theI < theXSpan.GetSize (); theI++) {
+            float theX = theXSpan[theI];
+            float theY = theYSpan[theI];
             
             if (theX>=inXMin && theX <= inXMax) {
                 if (!initialized) {
@@ -670,6 +834,149 @@ namespace SVGChart {
       return true;
     }
 
+    const float kSpatialIndexPointsPerCell = 4;
+    const int kSpatialIndexMaxCellSize = 32;
+
+    void PlotSpatialIndex::Clear () {
+      mBuilt = false;
+      mCols = 0;
+      mRows = 0;
+      mScreenX.clear ();
+      mScreenY.clear ();
+      mCellStart.clear ();
+      mCellPoints.clear ();
+    }
+
+    void PlotSpatialIndex::GetCell (float inScreenX, float inScreenY, long &outCol, long &outRow) const {
+      outCol = PMax (0L, PMin (mCols-1, (long)floor ((inScreenX-mRect.mX)/mUsedCellSize)));
+      outRow = PMax (0L, PMin (mRows-1, (long)floor ((inScreenY-mRect.mY)/mUsedCellSize)));
+    }
+
+    void PlotSpatialIndex::Build (const PlotDataBase &inXData, const PlotDataBase &inYData, const Trafo &inXTrafo, const Trafo &inYTrafo, const PRect &inRect) {
+      Clear ();
+      mRect = inRect;
+      mBuilt = true;
+      long theSize = PMin (inXData.GetSize (), inYData.GetSize ());
+      if (theSize <= 0 || inRect.mW <= 0 || inRect.mH <= 0) {
+        return;
+      }
+      mUsedCellSize = mCellSize;
+      if (mUsedCellSize <= 0) {
+        // aim for a handful of points per cell, but never below a pixel
+        float theArea = (float)inRect.mW*inRect.mH*kSpatialIndexPointsPerCell;
+        mUsedCellSize = PMax (1, PMin (kSpatialIndexMaxCellSize, (int)sqrt (theArea/theSize)));
+      }
+      mCols = (inRect.mW+mUsedCellSize-1)/mUsedCellSize;
+      mRows = (inRect.mH+mUsedCellSize-1)/mUsedCellSize;
+
+      // counting sort of the visible points by cell: count, prefix sum, scatter
+      mScreenX.resize (theSize);
+      mScreenY.resize (theSize);
+      vector<long> theCellOfPoint (theSize, -1);
+      mCellStart.assign (mCols*mRows+1, 0);
+      PlotDataSpan theXSpan = inXData.GetSpan ();
+      PlotDataSpan theYSpan = inYData.GetSpan ();
+      for (long theI=0;theI<theSize;theI++) {
+        float theX = inXTrafo.Transform (theXSpan[theI]);
+        float theY = inYTrafo.Transform (theYSpan[theI]);
+        mScreenX[theI] = theX;
+        mScreenY[theI] = theY;
+        if (!(theX >= inRect.mX && theX <= inRect.mX+inRect.mW && theY >= inRect.mY && theY <= inRect.mY+inRect.mH)) {
+          continue;// not visible (or NaN)
+        }
+        long theCol, theRow;
+        GetCell (theX, theY, theCol, theRow);
+        theCellOfPoint[theI] = theRow*mCols+theCol;
+        mCellStart[theCellOfPoint[theI]+1]++;
+      }
+      for (long theC=1;theC<(long)mCellStart.size ();theC++) {
+        mCellStart[theC] += mCellStart[theC-1];
+      }
+      mCellPoints.resize (mCellStart.back ());
+      vector<long> theFill (mCellStart.begin (), mCellStart.end ()-1);
+      for (long theI=0;theI<theSize;theI++) {
+        if (theCellOfPoint[theI] >= 0) {
+          mCellPoints[theFill[theCellOfPoint[theI]]++] = theI;
+        }
+      }
+    }
+
+    void PlotSpatialIndex::VisitCell (long inCol, long inRow, float inScreenX, float inScreenY, long &ioBest, float &ioBestDist2) const {
+      long theCell = inRow*mCols+inCol;
+      for (long theP=mCellStart[theCell];theP<mCellStart[theCell+1];theP++) {
+        long theI = mCellPoints[theP];
+        float theDX = mScreenX[theI]-inScreenX;
+        float theDY = mScreenY[theI]-inScreenY;
+        float theDist2 = theDX*theDX+theDY*theDY;
+        if (theDist2 < ioBestDist2) {
+          ioBestDist2 = theDist2;
+          ioBest = theI;
+        }
+      }
+    }
+
+    long PlotSpatialIndex::FindNearest (float inScreenX, float inScreenY, float inMaxDistance, float &outDistance) const {
+      outDistance = 0;
+      if (mCols == 0 || mRows == 0) {
+        return -1;
+      }
+      long theCol, theRow;
+      GetCell (inScreenX, inScreenY, theCol, theRow);
+
+      // walk rings of cells outward; a point in ring r+1 is at least r cells away
+      long theBest = -1;
+      float theBestDist2 = inMaxDistance*inMaxDistance;
+      long theMaxRing = PMax (mCols, mRows);
+      for (long theRing=0;theRing<=theMaxRing;theRing++) {
+        float theRingDist = (theRing-1)*(float)mUsedCellSize;
+        if (theRing > 1 && theRingDist*theRingDist > theBestDist2) {
+          break;
+        }
+        for (long theR=theRow-theRing;theR<=theRow+theRing;theR++) {
+          if (theR < 0 || theR >= mRows) {
+            continue;
+          }
+          bool theEdgeRow = (theR == theRow-theRing || theR == theRow+theRing);
+          long theStep = theEdgeRow ? 1 : 2*theRing;
+          for (long theC=theCol-theRing;theC<=theCol+theRing;theC+=PMax (theStep, 1L)) {
+            if (theC >= 0 && theC < mCols) {
+              VisitCell (theC, theR, inScreenX, inScreenY, theBest, theBestDist2);
+            }
+          }
+        }
+      }
+      if (theBest >= 0) {
+        outDistance = sqrt (theBestDist2);
+      }
+      return theBest;
+    }
+
+    void PlotSpatialIndex::FindInRect (const PRect &inScreenRect, vector<long> &outIndices) const {
+      outIndices.clear ();
+      if (mCols == 0 || mRows == 0) {
+        return;
+      }
+      float theX0 = inScreenRect.mX;
+      float theY0 = inScreenRect.mY;
+      float theX1 = inScreenRect.mX+inScreenRect.mW;
+      float theY1 = inScreenRect.mY+inScreenRect.mH;
+      long theCol0, theRow0, theCol1, theRow1;
+      GetCell (theX0, theY0, theCol0, theRow0);
+      GetCell (theX1, theY1, theCol1, theRow1);
+      for (long theR=theRow0;theR<=theRow1;theR++) {
+        for (long theC=theCol0;theC<=theCol1;theC++) {
+          long theCell = theR*mCols+theC;
+          for (long theP=mCellStart[theCell];theP<mCellStart[theCell+1];theP++) {
+            long theI = mCellPoints[theP];
+            if (mScreenX[theI] >= theX0 && mScreenX[theI] <= theX1 && mScreenY[theI] >= theY0 && mScreenY[theI] <= theY1) {
+              outIndices.push_back (theI);
+            }
+          }
+        }
+      }
+      sort (outIndices.begin (), outIndices.end ());
+    }
+
     float LinTrafo::Transform (float inValue) const {
       return inValue * mSlope + mOffset;
     }
@@ -702,12 +1009,15 @@ namespace SVGChart {
         return false;
       }
 
-      float theMin = mAxisSetup->mMin;
-      float theMajorTickSpan = mAxisSetup->mTickInfo.mMajorTickSpan;
+      double theMajorTickSpan = mAxisSetup->mTickInfo.mMajorTickSpan;
       int theDiv = mAxisSetup->mTickInfo.mTickDivision;
       mDelta = theMajorTickSpan/theDiv;
-      mCount = ceil (theMin/mDelta);
-      mCurrentTick = mCount*mDelta;
+      if (!(mDelta > 0) || !std::isfinite (mDelta)) {
+        return false;
+      }
+      // first and last index in closed form
+      mCount = (long)ceil (mAxisSetup->mMin/mDelta - kTickIndexTolerance);
+      mLastCount = (long)floor (mAxisSetup->mMax/mDelta + kTickIndexTolerance);
 
       mFormatString = mAxisSetup->mTickInfo.mFormatString;
 
@@ -715,22 +1025,46 @@ namespace SVGChart {
 
     }
 
-    bool LinTickIterator::GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString) {
+    bool LinTickIterator::Step (float &outTick, bool &outIsMajorTick) {
       if (!mAxisSetup) {
         return false;
       }
-      if (mCurrentTick>mAxisSetup->mMax*kLittleIncrease) {
+      if (mCount>mLastCount) {
         return false;
       }
-      outTick = mCurrentTick;
+      outTick = mCount*mDelta;
       outIsMajorTick = (mCount%mAxisSetup->mTickInfo.mTickDivision == 0);
-      outFormatString = mFormatString;
 
-      mCurrentTick += mDelta;
       mCount++;
       return true;
     }
 
+    bool LinTickIterator::GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString) {
+      if (!Step (outTick, outIsMajorTick)) {
+        return false;
+      }
+      outFormatString = mFormatString;
+      return true;
+    }
+
+    bool LinTickIterator::FillTicks (TickList &outTickList) {
+      outTickList.Clear ();
+      if (!Init ()) {
+        return false;
+      }
+      float theTick;
+      bool theIsMajorTick;
+      char theBuf[128];
+      while (Step (theTick, theIsMajorTick)) {
+        int theLength = 0;
+        if (theIsMajorTick) {
+          theLength = TickInfo::FormatLabel (theTick, mFormatString.c_str (), theBuf, sizeof (theBuf));
+        }
+        outTickList.AddTick (theTick, theIsMajorTick, theBuf, theLength);
+      }
+      return true;
+    }
+
     bool LinTickIterator::InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &ioTickInfo) const {
       if (inDivGuess <= kFloatSmall) {
         return false;
@@ -764,31 +1098,22 @@ namespace SVGChart {
       }
 
       float theMin = mAxisSetup->mMin;
-      //  float theMax = mAxisSetup->mMax;
-      float theMajorTickSpan = mAxisSetup->mTickInfo.mMajorTickSpan;
+      double theMajorTickSpan = mAxisSetup->mTickInfo.mMajorTickSpan;
       int theDiv = mAxisSetup->mTickInfo.mTickDivision;
       mDelta = theMajorTickSpan/theDiv;
       float theBase = mAxisSetup->mLogBase;
       long theLogFac =  1;//mAxisSetup->mLogFactor;
-      long thePowMin = (long)floor(SafeLog(theMin, theBase, theLogFac));
-      mCurrentTick = SafeExp (thePowMin, theBase, theLogFac);
-      mCount = 0;
-
-      // walk to the first tick
-
-      if (theMin<=0) {
+      if (theMin<=0 || !(mDelta > 0)) {
         return false;
       // error
       }
-      else {
-        // walk forward
-        float theNext = mCurrentTick+mDelta*SafeExp (thePowMin, theBase, theLogFac);;
-        while (theNext<=theMin*kLittleDecrease) {
-          mCurrentTick = theNext;
-          theNext += mDelta*SafeExp (thePowMin,theBase, theLogFac);
-          mCount++;
-        }
-      }
+      mPow = (int)floor(SafeLog(theMin, theBase, theLogFac));
+      mMinorPerDecade = PMax (1L, (long)ceil ((theBase-1)/mDelta - kTickIndexTolerance));
+
+      // the first tick is the last one not above the minimum
+      double theDecade = SafeExp (mPow, theBase, theLogFac);
+      mMinor = (long)floor ((theMin*kLittleDecrease/theDecade-1)/mDelta);
+      mMinor = PMax (0L, PMin (mMinor, mMinorPerDecade-1));
       return true;
     }
 
@@ -817,34 +1142,62 @@ namespace SVGChart {
       return true;
     }
 
-    bool LogTickIterator::GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString) {
+    bool LogTickIterator::Step (float &outTick, bool &outIsMajorTick, int &outPow) {
       if (!mAxisSetup) {
         return false;
       }
-      if (mCurrentTick>mAxisSetup->mMax*kLittleIncrease) {
-        return false;
-      }
-      outTick = mCurrentTick;
-      outIsMajorTick = (mCount%mAxisSetup->mTickInfo.mTickDivision == 0);
-      TickInfo::MakeFormatString (outTick, outFormatString);
       float theBase = mAxisSetup->mLogBase;
       float theLogFac = 1;//mAxisSetup->mLogFactor;
-      float theLogNow = SafeLog(mCurrentTick, theBase, theLogFac);
-      int thePowNow = (int)floor(theLogNow);
-      outIsMajorTick = false;
-      if (fabs (theLogNow-thePowNow)<kEps) {
-        outIsMajorTick = true;
+      double theTick = (1+mMinor*mDelta)*SafeExp (mPow, theBase, theLogFac);
+      if (theTick>mAxisSetup->mMax*kLittleIncrease) {
+        return false;
+      }
+      outTick = theTick;
+      outIsMajorTick = mMinor == 0;
+      outPow = mPow;
+
+      mMinor++;
+      if (mMinor >= mMinorPerDecade) {
+        mMinor = 0;
+        mPow++;
       }
+      return true;
+    }
 
+    bool LogTickIterator::GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString) {
+      int thePowNow;
+      if (!Step (outTick, outIsMajorTick, thePowNow)) {
+        return false;
+      }
+      TickInfo::MakeFormatString (outTick, outFormatString);
       if (mAxisSetup->mLogFactor>1) {
         char theBuf[128];
         snprintf (theBuf, 128, "%d", thePowNow*20);
         outFormatString = theBuf;
       }
+      return true;
+    }
 
-      mCurrentTick += mDelta*SafeExp (thePowNow, theBase, theLogFac);
-      mCount++;
-
+    bool LogTickIterator::FillTicks (TickList &outTickList) {
+      outTickList.Clear ();
+      if (!Init ()) {
+        return false;
+      }
+      float theTick;
+      bool theIsMajorTick;
+      int thePowNow;
+      char theBuf[128];
+      while (Step (theTick, theIsMajorTick, thePowNow)) {
+        int theLength = 0;
+        if (theIsMajorTick && mAxisSetup->mLogFactor>1) {
+          // decibels: the label is the power itself
+          theLength = std::to_chars (theBuf, theBuf+sizeof (theBuf), thePowNow*20).ptr-theBuf;
+        }
+        else if (theIsMajorTick) {
+          theLength = TickInfo::FormatLabel (theTick, TickInfo::GetFormatString (theTick), theBuf, sizeof (theBuf));
+        }
+        outTickList.AddTick (theTick, theIsMajorTick, theBuf, theLength);
+      }
       return true;
     }
 
@@ -889,16 +1242,70 @@ namespace SVGChart {
     }
 
     bool NamedTickIterator::GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString) {
-      if (LinTickIterator::GetNextTick (outTick, outIsMajorTick, outFormatString)) {
+      if (mStringList && LinTickIterator::GetNextTick (outTick, outIsMajorTick, outFormatString)) {
         int theIndex = PPlot::Round (outTick);
-        if (theIndex>=0 && theIndex < (int)mStringList.size ()) {
-          outFormatString = mStringList[theIndex];
+        if (theIndex>=0 && theIndex < (int)mStringList->size ()) {
+          outFormatString = (*mStringList)[theIndex];
           return true;
         }
       }
       return false;
     }
 
+    bool NamedTickIterator::FillTicks (TickList &outTickList) {
+      outTickList.Clear ();
+      if (!mStringList || !Init ()) {
+        return false;
+      }
+      float theTick;
+      bool theIsMajorTick;
+      while (Step (theTick, theIsMajorTick)) {
+        int theIndex = PPlot::Round (theTick);
+        if (theIndex<0 || theIndex >= (int)mStringList->size ()) {
+          break;
+        }
+        // names are used as they are, not as format strings
+        const string &theName = (*mStringList)[theIndex];
+        outTickList.AddTick (theTick, theIsMajorTick, theName.c_str (), theName.size ());
+      }
+      return true;
+    }
+
+    bool NamedTickIterator::FitLabels (float inParRange, float inScreenRange, Painter &inPainter, TickInfo &ioTickInfo) const {
+      if (!mStringList || !mAxisSetup || inParRange <= 0 || inScreenRange <= 0) {
+        return false;
+      }
+      // only the labels on the axis count
+      long theFirst = PMax (0L, (long)ceil (mAxisSetup->mMin));
+      long theLast = PMin ((long)mStringList->size ()-1, (long)floor (mAxisSetup->mMax));
+      long theMaxWidth = 0;
+      for (long theI=theFirst; theI<=theLast; theI++) {
+        theMaxWidth = PMax (theMaxWidth, inPainter.CalculateTextDrawSize ((*mStringList)[theI].c_str ()));
+      }
+
+      // room a label needs along the axis; slanted labels stack like parallel lines
+      float theAngle = ioTickInfo.mLabelAngle*kPi/180;
+      float theNeeded = theMaxWidth;
+      if (fabs (sin (theAngle)) > kEps) {
+        theNeeded = PMin (theNeeded/PMax (kEps, (float)fabs (cos (theAngle))), inPainter.GetFontHeight ()/(float)fabs (sin (theAngle)));
+      }
+
+      float thePixelsPerCategory = inScreenRange/inParRange;
+      long theStride = 1;
+      const int kStrideSteps[3] = {2, 5, 10};// 1, 2, 5, 10, 20, 50, ...
+      for (long theDecade=1; theStride*thePixelsPerCategory < theNeeded && theDecade < LONG_MAX/10; theDecade *= 10) {
+        for (int theStep : kStrideSteps) {
+          theStride = theStep*theDecade;
+          if (theStride*thePixelsPerCategory >= theNeeded) {
+            break;
+          }
+        }
+      }
+      ioTickInfo.mMajorTickSpan = theStride;
+      ioTickInfo.mTickDivision = 1;
+      return true;
+    }
+
     bool NamedTickIterator::InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &outTickInfo) const {
       if (LinTickIterator::InitFromRanges (inParRange, inOrthoScreenRange, inDivGuess, outTickInfo)) {
         outTickInfo.mTickDivision = 1;
@@ -907,6 +1314,433 @@ namespace SVGChart {
       return false;
     }
 
+    const long kSecondsPerDay = 86400;
+    const long kMondayEpochDay = 4;// 1970-01-05 was a monday
+    const double kSecondsPerMonth = 2629746;// average gregorian month
+    const double kMinTimeStep = 1e-9;
+    const double kMaxTimeStepYears = 1e6;
+
+    const TimeTickIterator::Step kTimeSteps[] = {
+      {1, 0, 5}, {2, 0, 4}, {5, 0, 5}, {10, 0, 5}, {15, 0, 3}, {30, 0, 6},
+      {60, 0, 4}, {120, 0, 4}, {300, 0, 5}, {600, 0, 5}, {900, 0, 3}, {1800, 0, 6},
+      {3600, 0, 4}, {7200, 0, 4}, {10800, 0, 3}, {21600, 0, 6}, {43200, 0, 4},
+      {86400, 0, 4}, {172800, 0, 2}, {604800, 0, 7}, {1209600, 0, 2},
+      {kSecondsPerMonth, 1, 1}, {2*kSecondsPerMonth, 2, 2}, {3*kSecondsPerMonth, 3, 3}, {6*kSecondsPerMonth, 6, 6},
+      {12*kSecondsPerMonth, 12, 4}, {24*kSecondsPerMonth, 24, 2}, {60*kSecondsPerMonth, 60, 5},
+      {120*kSecondsPerMonth, 120, 5}, {240*kSecondsPerMonth, 240, 4}, {600*kSecondsPerMonth, 600, 5}
+    };
+
+    int64_t FloorDiv (int64_t inA, int64_t inB) {
+      int64_t theQ = inA/inB;
+      if (inA%inB != 0 && (inA<0) != (inB<0)) {
+        theQ--;
+      }
+      return theQ;
+    }
+
+    // days since 1970-01-01 of a proleptic gregorian date, after H. Hinnant
+    long DaysFromCivil (long inYear, int inMonth, int inDay) {
+      inYear -= inMonth <= 2;
+      long theEra = (inYear >= 0 ? inYear : inYear-399)/400;
+      long theYearOfEra = inYear-theEra*400;
+      long theDayOfYear = (153*(inMonth+(inMonth > 2 ? -3 : 9))+2)/5+inDay-1;
+      long theDayOfEra = theYearOfEra*365+theYearOfEra/4-theYearOfEra/100+theDayOfYear;
+      return theEra*146097+theDayOfEra-719468;
+    }
+
+    void CivilFromDays (long inDays, int &outYear, int &outMonth, int &outDay) {
+      inDays += 719468;
+      long theEra = (inDays >= 0 ? inDays : inDays-146096)/146097;
+      long theDayOfEra = inDays-theEra*146097;
+      long theYearOfEra = (theDayOfEra-theDayOfEra/1460+theDayOfEra/36524-theDayOfEra/146096)/365;
+      long theDayOfYear = theDayOfEra-(365*theYearOfEra+theYearOfEra/4-theYearOfEra/100);
+      long theMP = (5*theDayOfYear+2)/153;
+      outDay = theDayOfYear-(153*theMP+2)/5+1;
+      outMonth = theMP < 10 ? theMP+3 : theMP-9;
+      outYear = theYearOfEra+theEra*400+(outMonth <= 2);
+    }
+
+    // zero padded decimal, returns the end of the written digits
+    char * WriteDigits (char *outBuf, int64_t inValue, int inDigits) {
+      if (inValue < 0) {
+        *outBuf++ = '-';
+        inValue = -inValue;
+      }
+      char theTmp[24];
+      int theCount = 0;
+      do {
+        theTmp[theCount++] = '0'+inValue%10;
+        inValue /= 10;
+      } while (inValue > 0);
+      while (theCount < inDigits) {
+        theTmp[theCount++] = '0';
+      }
+      while (theCount > 0) {
+        *outBuf++ = theTmp[--theCount];
+      }
+      return outBuf;
+    }
+
+    // 1, 2, 5 times a power of ten, not below inValue
+    double RoundUpDecimal (double inValue, int &outDivision) {
+      double thePow = pow (10, floor (log10 (inValue)));
+      double theMantissa = inValue/thePow;
+      if (theMantissa <= 1*kLittleIncrease) {
+        outDivision = 5;
+        return thePow;
+      }
+      if (theMantissa <= 2*kLittleIncrease) {
+        outDivision = 4;
+        return 2*thePow;
+      }
+      if (theMantissa <= 5*kLittleIncrease) {
+        outDivision = 5;
+        return 5*thePow;
+      }
+      outDivision = 5;
+      return 10*thePow;
+    }
+
+    // digits after the decimal point for a sub-second step
+    int FractionDigits (double inStep) {
+      return PMin (9, (int)ceil (-log10 (inStep)-kEps));
+    }
+
+    float AxisSetup::TimeValue (int64_t inSeconds, long inNanoseconds) const {
+      double theOriginSeconds = floor (mTimeOrigin);
+      double theSeconds = (double)(inSeconds-(int64_t)theOriginSeconds);
+      return (theSeconds+(inNanoseconds*1e-9-(mTimeOrigin-theOriginSeconds)))/mTimeUnit;
+    }
+
+    TimeTickIterator::Step TimeTickIterator::ChooseStep (double inSeconds) {
+      Step theStep;
+      if (!(inSeconds > kMinTimeStep)) {
+        inSeconds = kMinTimeStep;
+      }
+      if (inSeconds < kLittleDecrease) {
+        theStep.mSeconds = RoundUpDecimal (inSeconds, theStep.mDivision);
+        theStep.mMonths = 0;
+        return theStep;
+      }
+      for (const Step &theCandidate : kTimeSteps) {
+        if (theCandidate.mSeconds >= inSeconds*kLittleDecrease) {
+          return theCandidate;
+        }
+      }
+      double theYears = RoundUpDecimal (inSeconds/(12*kSecondsPerMonth), theStep.mDivision);
+      theYears = PMin (theYears, kMaxTimeStepYears);
+      theStep.mMonths = (long)theYears*12;
+      theStep.mSeconds = theStep.mMonths*kSecondsPerMonth;
+      return theStep;
+    }
+
+    bool TimeTickIterator::InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &ioTickInfo) const {
+      if (inDivGuess <= kFloatSmall || !mAxisSetup || !(mAxisSetup->mTimeUnit > 0)) {
+        return false;
+      }
+      Step theStep = ChooseStep (inParRange*mAxisSetup->mTimeUnit/inDivGuess);
+      ioTickInfo.mMajorTickSpan = theStep.mSeconds/mAxisSetup->mTimeUnit;
+      ioTickInfo.mTickDivision = theStep.mDivision;
+      if (ioTickInfo.mAutoTickSize) {
+          ioTickInfo.mMinorTickScreenSize = PMax (kMinMinorTickScreenSize, PPlot::Round (inOrthoScreenRange*kRelMinorTickSize));
+          ioTickInfo.mMajorTickScreenSize = PMax (ioTickInfo.mMinorTickScreenSize+1, PPlot::Round (inOrthoScreenRange*kRelMajorTickSize));
+      }
+      return true;
+    }
+
+    const char * TimeTickIterator::GetSampleLabel (const TickInfo &inTickInfo) const {
+      static const char * const kSubSecondSamples[] = {"00:00:00", "00:00:00.0", "00:00:00.00", "00:00:00.000",
+        "00:00:00.0000", "00:00:00.00000", "00:00:00.000000", "00:00:00.0000000", "00:00:00.00000000", "00:00:00.000000000"};
+      static const char * const kDatedSubSecondSamples[] = {"0000-00-00 00:00:00", "0000-00-00 00:00:00.0",
+        "0000-00-00 00:00:00.00", "0000-00-00 00:00:00.000", "0000-00-00 00:00:00.0000", "0000-00-00 00:00:00.00000",
+        "0000-00-00 00:00:00.000000", "0000-00-00 00:00:00.0000000", "0000-00-00 00:00:00.00000000",
+        "0000-00-00 00:00:00.000000000"};
+      double theUnit = mAxisSetup ? mAxisSetup->mTimeUnit : 1;
+      Step theStep = ChooseStep (inTickInfo.mMajorTickSpan*theUnit);
+      if (theStep.mMonths > 0) {
+        return theStep.mMonths%12 == 0 ? "0000" : "0000-00";
+      }
+      if (theStep.mSeconds >= kSecondsPerDay) {
+        return "0000-00-00";
+      }
+      // the widest label is a dated one
+      bool theDated = SpansDays ();
+      if (theStep.mSeconds >= 60) {
+        return theDated ? "0000-00-00 00:00" : "00:00";
+      }
+      if (theStep.mSeconds >= 1) {
+        return theDated ? "0000-00-00 00:00:00" : "00:00:00";
+      }
+      int theDigits = FractionDigits (theStep.mSeconds);
+      return theDated ? kDatedSubSecondSamples[theDigits] : kSubSecondSamples[theDigits];
+    }
+
+    bool TimeTickIterator::SpansDays () const {
+      if (!mAxisSetup) {
+        return false;
+      }
+      double theUnit = mAxisSetup->mTimeUnit;
+      double theFirst = floor ((mAxisSetup->mTimeOrigin+mAxisSetup->mMin*theUnit)/kSecondsPerDay);
+      double theLast = floor ((mAxisSetup->mTimeOrigin+mAxisSetup->mMax*theUnit)/kSecondsPerDay);
+      return theFirst != theLast;
+    }
+
+    bool TimeTickIterator::Init () {
+      if (!mAxisSetup || !(mAxisSetup->mTimeUnit > 0)) {
+        return false;
+      }
+      double theUnit = mAxisSetup->mTimeUnit;
+      mStep = ChooseStep (mAxisSetup->mTickInfo.mMajorTickSpan*theUnit);
+      double theOrigin = mAxisSetup->mTimeOrigin;
+      long theOriginDay = (long)floor (theOrigin/kSecondsPerDay);
+      mHasLabelDay = false;
+      mDated = mStep.mMonths == 0 && mStep.mSeconds < kSecondsPerDay && SpansDays ();
+
+      if (mStep.mMonths > 0) {
+        mMinorMonths = PMax (1L, mStep.mMonths/mStep.mDivision);
+        mBaseDay = theOriginDay;
+        mOriginOffset = theOrigin-mBaseDay*(double)kSecondsPerDay;
+        double theTolerance = kTickIndexTolerance*mMinorMonths*kSecondsPerMonth;
+        // months containing the ends of the axis
+        int theYear, theMonth, theDay;
+        double theStart = mAxisSetup->mMin*theUnit+mOriginOffset-theTolerance;
+        CivilFromDays (mBaseDay+(long)floor (theStart/kSecondsPerDay), theYear, theMonth, theDay);
+        int64_t theFirstMonth = (int64_t)theYear*12+theMonth-1;
+        if ((DaysFromCivil (theYear, theMonth, 1)-mBaseDay)*(double)kSecondsPerDay < theStart) {
+          theFirstMonth++;
+        }
+        double theEnd = mAxisSetup->mMax*theUnit+mOriginOffset+theTolerance;
+        CivilFromDays (mBaseDay+(long)floor (theEnd/kSecondsPerDay), theYear, theMonth, theDay);
+        int64_t theLastMonth = (int64_t)theYear*12+theMonth-1;
+        mIndex = -FloorDiv (-theFirstMonth, mMinorMonths);
+        mLastIndex = FloorDiv (theLastMonth, mMinorMonths);
+        return true;
+      }
+
+      mMinorSeconds = mStep.mSeconds/mStep.mDivision;
+      mBaseDay = theOriginDay;
+      mBaseIndex = 0;// steps below a day divide it, so midnight is aligned
+      if (mMinorSeconds >= kSecondsPerDay) {
+        long theMinorDays = PPlot::Round (mMinorSeconds/kSecondsPerDay);
+        long theAnchorDay = (long)mStep.mSeconds%(7*kSecondsPerDay) == 0 ? kMondayEpochDay : 0;
+        mBaseIndex = FloorDiv (theOriginDay-theAnchorDay, theMinorDays);
+        mBaseDay = theAnchorDay+mBaseIndex*theMinorDays;
+      }
+      mOriginOffset = theOrigin-mBaseDay*(double)kSecondsPerDay;
+      mIndex = (int64_t)ceil ((mAxisSetup->mMin*theUnit+mOriginOffset)/mMinorSeconds-kTickIndexTolerance);
+      mLastIndex = (int64_t)floor ((mAxisSetup->mMax*theUnit+mOriginOffset)/mMinorSeconds+kTickIndexTolerance);
+      return true;
+    }
+
+    bool TimeTickIterator::NextTick (float &outTick, bool &outIsMajorTick, long &outDay, double &outSecondOfDay) {
+      if (!mAxisSetup || mIndex>mLastIndex) {
+        return false;
+      }
+      double theSeconds;// since mBaseDay
+      if (mStep.mMonths > 0) {
+        int64_t theMonth = mIndex*mMinorMonths;
+        int64_t theYear = FloorDiv (theMonth, 12);
+        outDay = DaysFromCivil (theYear, theMonth-theYear*12+1, 1);
+        outSecondOfDay = 0;
+        theSeconds = (outDay-mBaseDay)*(double)kSecondsPerDay;
+        outIsMajorTick = theMonth%mStep.mMonths == 0;
+      }
+      else {
+        theSeconds = mIndex*mMinorSeconds;
+        double theDays = floor (theSeconds/kSecondsPerDay);
+        outDay = mBaseDay+(long)theDays;
+        outSecondOfDay = theSeconds-theDays*kSecondsPerDay;
+        int64_t theMinor = mBaseIndex+mIndex;
+        outIsMajorTick = theMinor-FloorDiv (theMinor, mStep.mDivision)*mStep.mDivision == 0;
+      }
+      outTick = (theSeconds-mOriginOffset)/mAxisSetup->mTimeUnit;
+      mIndex++;
+      return true;
+    }
+
+    int TimeTickIterator::FormatLabel (long inDay, double inSecondOfDay, char *outBuf) {
+      int theDigits = 0;
+      if (mStep.mMonths == 0 && mStep.mSeconds < 1) {
+        theDigits = FractionDigits (mStep.mSeconds);
+      }
+      // round to what is shown first, that may roll over into the next day
+      int64_t theScale = 1;
+      for (int theI=0; theI<theDigits; theI++) {
+        theScale *= 10;
+      }
+      int64_t theUnits = llround (inSecondOfDay*theScale);
+      if (theUnits >= kSecondsPerDay*theScale) {
+        theUnits -= kSecondsPerDay*theScale;
+        inDay++;
+      }
+      // the calendar breakdown only changes with the day
+      bool theNewDay = !mHasLabelDay || inDay != mLabelDay;
+      if (theNewDay) {
+        CivilFromDays (inDay, mLabelYear, mLabelMonth, mLabelDayOfMonth);
+        mLabelDay = inDay;
+        mHasLabelDay = true;
+      }
+
+      char *theEnd = outBuf;
+      if (mDated && theNewDay) {
+        theEnd = WriteDigits (theEnd, mLabelYear, 4);
+        *theEnd++ = '-';
+        theEnd = WriteDigits (theEnd, mLabelMonth, 2);
+        *theEnd++ = '-';
+        theEnd = WriteDigits (theEnd, mLabelDayOfMonth, 2);
+        *theEnd++ = ' ';
+      }
+      if (mStep.mMonths > 0 || mStep.mSeconds >= kSecondsPerDay) {
+        theEnd = WriteDigits (theEnd, mLabelYear, 4);
+        if (mStep.mMonths == 0 || mStep.mMonths%12 != 0) {
+          *theEnd++ = '-';
+          theEnd = WriteDigits (theEnd, mLabelMonth, 2);
+        }
+        if (mStep.mMonths == 0) {
+          *theEnd++ = '-';
+          theEnd = WriteDigits (theEnd, mLabelDayOfMonth, 2);
+        }
+      }
+      else {
+        int64_t theSeconds = theUnits/theScale;
+        theEnd = WriteDigits (theEnd, theSeconds/3600, 2);
+        *theEnd++ = ':';
+        theEnd = WriteDigits (theEnd, theSeconds/60%60, 2);
+        if (mStep.mSeconds < 60) {
+          *theEnd++ = ':';
+          theEnd = WriteDigits (theEnd, theSeconds%60, 2);
+        }
+        if (theDigits > 0) {
+          *theEnd++ = '.';
+          theEnd = WriteDigits (theEnd, theUnits%theScale, theDigits);
+        }
+      }
+      *theEnd = 0;
+      return theEnd-outBuf;
+    }
+
+    bool TimeTickIterator::GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString) {
+      long theDay;
+      double theSecondOfDay;
+      if (!NextTick (outTick, outIsMajorTick, theDay, theSecondOfDay)) {
+        return false;
+      }
+      outFormatString.clear ();
+      if (outIsMajorTick) {
+        char theBuf[64];
+        FormatLabel (theDay, theSecondOfDay, theBuf);
+        outFormatString = theBuf;
+      }
+      return true;
+    }
+
+    bool TimeTickIterator::FillTicks (TickList &outTickList) {
+      outTickList.Clear ();
+      if (!Init ()) {
+        return false;
+      }
+      float theTick;
+      bool theIsMajorTick;
+      long theDay;
+      double theSecondOfDay;
+      char theBuf[64];
+      while (NextTick (theTick, theIsMajorTick, theDay, theSecondOfDay)) {
+        int theLength = 0;
+        if (theIsMajorTick) {
+          theLength = FormatLabel (theDay, theSecondOfDay, theBuf);
+        }
+        outTickList.AddTick (theTick, theIsMajorTick, theBuf, theLength);
+      }
+      return true;
+    }
+
+    void Painter::FillRects (const PRect *inRects, long inCount) {
+      for (long theI=0;theI<inCount;theI++) {
+        FillRect (inRects[theI].mX, inRects[theI].mY, inRects[theI].mW, inRects[theI].mH);
+      }
+    }
+
+    void DummyPainter::DrawLine (float inX1, float inY1, float inX2, float inY2) {
+      mLineCount++;
+      AddBounds (PMin (inX1, inX2), PMin (inY1, inY2), PMax (inX1, inX2), PMax (inY1, inY2));
+    }
+
+    void DummyPainter::FillRect (int inX, int inY, int inW, int inH) {
+      mRectCount++;
+      // bars come with negative heights
+      AddBounds (PMin (inX, inX+inW), PMin (inY, inY+inH), PMax (inX, inX+inW), PMax (inY, inY+inH));
+    }
+
+    void DummyPainter::InvertRect (int inX, int inY, int inW, int inH) {
+      mRectCount++;
+      // bars come with negative heights
+      AddBounds (PMin (inX, inX+inW), PMin (inY, inY+inH), PMax (inX, inX+inW), PMax (inY, inY+inH));
+    }
+
+    long DummyPainter::CalculateTextDrawSize (const char *inString) {
+      long theCount = 0;
+      for (const char *theC = inString; *theC; theC++) {
+        // skip UTF-8 continuation bytes
+        theCount += (*theC & 0xC0) != 0x80;
+      }
+      return theCount*mCharWidth;
+    }
+
+    void DummyPainter::DrawText (int inX, int inY, const char *inString) {
+      mTextCount++;
+      AddBounds (inX, inY-mFontHeight, inX+CalculateTextDrawSize (inString), inY);
+    }
+
+    void DummyPainter::DrawRotatedText (int inX, int inY, float inDegrees, const char *inString) {
+      mTextCount++;
+      // the baseline from the anchor, grown by the font height on all sides
+      float theWidth = CalculateTextDrawSize (inString);
+      float theEndX = inX+theWidth*cos (inDegrees*kPi/180);
+      float theEndY = inY+theWidth*sin (inDegrees*kPi/180);
+      AddBounds (PMin ((float)inX, theEndX)-mFontHeight, PMin ((float)inY, theEndY)-mFontHeight,
+                 PMax ((float)inX, theEndX)+mFontHeight, PMax ((float)inY, theEndY)+mFontHeight);
+    }
+
+    bool DummyPainter::DrawImage (int inX, int inY, int inW, int inH, [[maybe_unused]] const unsigned char *inRGBA) {
+      mImageCount++;
+      AddBounds (inX, inY, inX+inW, inY+inH);
+      return true;
+    }
+
+    void DummyPainter::Reset () {
+      mLineCount = 0;
+      mRectCount = 0;
+      mTextCount = 0;
+      mImageCount = 0;
+      mHasBounds = false;
+    }
+
+    bool DummyPainter::GetBounds (PRect &outRect) const {
+      if (!mHasBounds) {
+        return false;
+      }
+      outRect.mX = floor (mMinX);
+      outRect.mY = floor (mMinY);
+      outRect.mW = ceil (mMaxX)-outRect.mX;
+      outRect.mH = ceil (mMaxY)-outRect.mY;
+      return true;
+    }
+
+    void DummyPainter::AddBounds (float inX1, float inY1, float inX2, float inY2) {
+      if (!mHasBounds) {
+        mMinX = inX1;
+        mMinY = inY1;
+        mMaxX = inX2;
+        mMaxY = inY2;
+        mHasBounds = true;
+        return;
+      }
+      mMinX = PMin (mMinX, inX1);
+      mMinY = PMin (mMinY, inY1);
+      mMaxX = PMax (mMaxX, inX2);
+      mMaxY = PMax (mMaxY, inY2);
+    }
+
     bool PainterTester::Draw (Painter &inPainter) {
 
       const char * theString = "The quick brown fox...";
@@ -956,9 +1790,91 @@ namespace SVGChart {
       if (mOwnsPPlotDrawer) {
         delete mPPlotDrawer;
       }
+      if (mXAxisGroup) {
+        mXAxisGroup->RemovePlot (this);
+      }
+    }
+
+    // Adds the time until it goes out of scope to a stage of the profile, if any.
+    class StageTimer {
+     public:
+      StageTimer (RenderProfile *inProfile, int inStage)
+          : mProfile (inProfile), mStage (inStage)
+        {
+          if (mProfile) {
+            mStart = chrono::steady_clock::now ();
+          }
+        }
+      ~StageTimer () {
+        if (mProfile) {
+          mProfile->mStageSeconds[mStage] += chrono::duration<double> (chrono::steady_clock::now ()-mStart).count ();
+          mProfile->mStageCalls[mStage]++;
+        }
+      }
+     protected:
+      RenderProfile *mProfile;
+      int mStage;
+      chrono::steady_clock::time_point mStart;
+    };
+
+    void RenderProfile::Clear () {
+      mDrawCount = 0;
+      mTotalSeconds = 0;
+      for (int theI=0;theI<kStageCount;theI++) {
+        mStageSeconds[theI] = 0;
+        mStageCalls[theI] = 0;
+      }
+      mPlotSeconds.clear ();
+      mPointsVisited = 0;
+      mPrimitives = 0;
+      mBytes = 0;
+    }
+
+    const char * RenderProfile::GetStageName (int inStage) {
+      static const char *kNames[kStageCount] = {"configure", "ranges", "ticks", "transforms", "calculators", "pre_drawers",
+        "background", "grid", "axes", "legend", "plots", "post_drawers"};
+      if (inStage < 0 || inStage >= kStageCount) {
+        return "";
+      }
+      return kNames[inStage];
+    }
+
+    string RenderProfile::toJSON () const {
+      char theBuf[128];
+      string theJSON = "{";
+      snprintf (theBuf, sizeof (theBuf), "\"draws\":%ld,\"seconds\":%.9g,\"stages\":{", mDrawCount, mTotalSeconds);
+      theJSON += theBuf;
+      for (int theI=0;theI<kStageCount;theI++) {
+        snprintf (theBuf, sizeof (theBuf), "%s\"%s\":{\"seconds\":%.9g,\"calls\":%ld}", theI ? "," : "",
+          GetStageName (theI), mStageSeconds[theI], mStageCalls[theI]);
+        theJSON += theBuf;
+      }
+      theJSON += "},\"plot_seconds\":[";
+      for (size_t theI=0;theI<mPlotSeconds.size ();theI++) {
+        snprintf (theBuf, sizeof (theBuf), "%s%.9g", theI ? "," : "", mPlotSeconds[theI]);
+        theJSON += theBuf;
+      }
+      snprintf (theBuf, sizeof (theBuf), "],\"points\":%ld,\"primitives\":%ld,\"bytes\":%ld}", mPointsVisited, mPrimitives, mBytes);
+      theJSON += theBuf;
+      return theJSON;
     }
 
     bool PPlot::Draw (Painter &inPainter) {
+      if (!mProfile) {
+        return DrawStages (inPainter);
+      }
+      chrono::steady_clock::time_point theStart = chrono::steady_clock::now ();
+      long theBytes = inPainter.GetOutputSize ();
+      CountingPainter theCounter (inPainter);
+      bool theResult = DrawStages (theCounter);
+      mProfile->mDrawCount++;
+      mProfile->mTotalSeconds += chrono::duration<double> (chrono::steady_clock::now ()-theStart).count ();
+      mProfile->mPrimitives += theCounter.mPrimitiveCount;
+      mProfile->mBytes += inPainter.GetOutputSize ()-theBytes;
+      return theResult;
+    }
+
+    bool PPlot::DrawStages (Painter &inPainter) {
       PRect theRect;
       theRect.mX = mMargins.mLeft;
       theRect.mY = mMargins.mTop;
@@ -973,8 +1889,173 @@ namespace SVGChart {
         return true;
       }
 
-      if (!ConfigureSelf ()) {
-        return false;
+      if (!mReuseLayout) {
+        SetDataChanged ();// values may have been edited in place
+      }
+      int theDirtyFlags = GetDirtyFlags (inPainter);
+      if (theDirtyFlags) {
+        bool theReuseRanges = !(theDirtyFlags & (kDataDirty | kAxisDirty));
+        if (mLayout.mValid && !(theDirtyFlags & kAxisDirty)) {
+          // the axis setups hold the results of the last layout
+          mXAxisSetup = mLayout.mXInput;
+          mYAxisSetup = mLayout.mYInput;
+        }
+        if (!theReuseRanges) {
+          StageTimer theTimer (mProfile, RenderProfile::kConfigure);
+          if (!ConfigureSelf ()) {
+            return false;
+          }
+          mStageCounts.mConfigure++;
+          mLayout.mXInput = mXAxisSetup;
+          mLayout.mYInput = mYAxisSetup;
+        }
+        StoreLayoutInputs (inPainter);
+        if (!CalculateLayout (theRect, inPainter, theReuseRanges)) {
+          return false;
+        }
+      }
+
+      // hooks for some final calculations
+      if (!mPostCalculatorList.empty ()) {
+        StageTimer theTimer (mProfile, RenderProfile::kCalculators);
+        for (PCalculator::tList::iterator thePostC=mPostCalculatorList.begin ();thePostC!=mPostCalculatorList.end();thePostC++) {
+          PCalculator *thePostCalculator = *thePostC;
+          thePostCalculator->Calculate (inPainter, *this);
+        }
+      }
+
+      if (!mPreDrawerList.empty ()) {
+        StageTimer theTimer (mProfile, RenderProfile::kPreDrawers);
+        for (PDrawer::tList::iterator thePre1=mPreDrawerList.begin();thePre1!=mPreDrawerList.end ();thePre1++) {
+          PDrawer *thePreDrawer = *thePre1;
+          thePreDrawer->Prepare (inPainter, *this);
+        }
+      }
+
+      mPlotRect = theRect;
+      if (theDirtyFlags) {
+        // hit test indices are rebuilt lazily against the new transformations
+        mSpatialIndexList.resize (mPlotDataContainer.GetPlotCount ());
+        for (PlotSpatialIndex &theIndex : mSpatialIndexList) {
+          theIndex.Clear ();
+        }
+
+        // ticks and their labels, shared by grid and axes
+        StageTimer theTimer (mProfile, RenderProfile::kTicks);
+        // named and time ticks also depend on this plot's labels and painter
+        bool theShareTicks = mXAxisGroup && (mXTickIterator == &mXLinTickIterator || mXTickIterator == &mXLogTickIterator);
+        if (!theShareTicks || !mXAxisGroup->GetTicks (mXAxisSetup, theRect.mW, mXTickList)) {
+          if (!mXTickIterator->FillTicks (mXTickList)) {
+            return false;
+          }
+          if (theShareTicks) {
+            mXAxisGroup->StoreTicks (mXAxisSetup, theRect.mW, mXTickList);
+          }
+        }
+        if (!mYTickIterator->FillTicks (mYTickList)) {
+          return false;
+        }
+        mStageCounts.mTickLists++;
+        mLayout.mXOutput = mXAxisSetup;
+        mLayout.mYOutput = mYAxisSetup;
+        mLayout.mValid = true;
+      }
+
+      mStageCounts.mEmit++;
+
+      // Drawing !
+
+      inPainter.SetLineColor (0,0,0);
+      inPainter.SetClipRect (0, 0, inPainter.GetWidth (), inPainter.GetHeight ());
+
+      // draw entire background, including the margins (for scrolling...)
+      PRect fullRect;
+      fullRect.mX = 0;
+      fullRect.mY = 0;
+      fullRect.mW = inPainter.GetWidth ();
+      fullRect.mH = inPainter.GetHeight ();
+      {
+        StageTimer theTimer (mProfile, RenderProfile::kBackground);
+        if (!DrawPlotBackground (fullRect, inPainter)) {
+          return false;
+        }
+      }
+
+      if (!mPreDrawerList.empty ()) {
+        StageTimer theTimer (mProfile, RenderProfile::kPreDrawers);
+        for (PDrawer::tList::iterator thePre=mPreDrawerList.begin ();thePre!=mPreDrawerList.end();thePre++) {
+          PDrawer *thePreDrawer = *thePre;
+          thePreDrawer->Draw (inPainter);
+        }
+      }
+
+      {
+        StageTimer theTimer (mProfile, RenderProfile::kGrid);
+        if (!DrawGridXAxis (theRect, inPainter)) {
+          return false;
+        }
+
+        if (!DrawGridYAxis (theRect, inPainter)) {
+          return false;
+        }
+      }
+
+      {
+        StageTimer theTimer (mProfile, RenderProfile::kAxes);
+        if (!DrawXAxis (theRect, inPainter)) {
+          return false;
+        }
+
+        if (!DrawYAxis (theRect, inPainter)) {
+          return false;
+        }
+      }
+
+      {
+        StageTimer theTimer (mProfile, RenderProfile::kLegend);
+        if (!DrawLegend (theRect, inPainter)) {
+          return false;
+        }
+      }
+
+      // clip the plotregion while drawing plots
+      inPainter.SetClipRect (theRect.mX, theRect.mY, theRect.mW, theRect.mH);
+
+
+      {
+        StageTimer theTimer (mProfile, RenderProfile::kPlots);
+        for (int theI=0;theI<mPlotDataContainer.GetPlotCount ();theI++) {
+          chrono::steady_clock::time_point theStart;
+          if (mProfile) {
+            theStart = chrono::steady_clock::now ();
+          }
+          if (!DrawPlot (theI, theRect, inPainter)) {
+            return false;
+          }
+          if (mProfile) {
+            if (int (mProfile->mPlotSeconds.size ()) <= theI) {
+              mProfile->mPlotSeconds.resize (theI+1);
+            }
+            mProfile->mPlotSeconds[theI] += chrono::duration<double> (chrono::steady_clock::now ()-theStart).count ();
+            mProfile->mPointsVisited += mPlotDataContainer.GetConstYData (theI)->GetSize ();
+          }
+        }
+      }
+
+      if (!mPostDrawerList.empty ()) {
+        StageTimer theTimer (mProfile, RenderProfile::kPostDrawers);
+        for (PDrawer::tList::iterator thePost=mPostDrawerList.begin ();thePost!=mPostDrawerList.end();thePost++) {
+          PDrawer *thePostDrawer = *thePost;
+          thePostDrawer->Draw (inPainter);
+        }
+      }
+
+      return true;
+    }
+
+    bool PPlot::CalculateLayout (const PRect &inRect, Painter &inPainter, bool inReuseRanges) {
+      if (!inReuseRanges) {
+        mLayout.mRangeCount = 0;
       }
       bool theShouldRepeat = true;
       long theRepeatCount = 0;
@@ -986,8 +2067,25 @@ namespace SVGChart {
           return false;
         }
 
-        if (!CalculateAxisRanges ()) {
-          return false;
+        // the ranges don't depend on the painter or the margins
+        float *theRanges = mLayout.mRanges[theRepeatCount-1];
+        if (inReuseRanges && theRepeatCount<=mLayout.mRangeCount) {
+          mXAxisSetup.mMin = theRanges[0];
+          mXAxisSetup.mMax = theRanges[1];
+          mYAxisSetup.mMin = theRanges[2];
+          mYAxisSetup.mMax = theRanges[3];
+        }
+        else {
+          StageTimer theTimer (mProfile, RenderProfile::kRanges);
+          if (!CalculateAxisRanges ()) {
+            return false;
+          }
+          mStageCounts.mRanges++;
+          theRanges[0] = mXAxisSetup.mMin;
+          theRanges[1] = mXAxisSetup.mMax;
+          theRanges[2] = mYAxisSetup.mMin;
+          theRanges[3] = mYAxisSetup.mMax;
+          mLayout.mRangeCount = theRepeatCount;
         }
 
         if (!this->CheckRange (mXAxisSetup)) {
@@ -998,22 +2096,31 @@ namespace SVGChart {
           return false;
         }
 
-        if (!CalculateTickInfo (theRect, inPainter)) {
-          return false;
+        {
+          StageTimer theTimer (mProfile, RenderProfile::kTicks);
+          if (!CalculateTickInfo (inRect, inPainter)) {
+            return false;
+          }
+          mStageCounts.mTicks++;
         }
 
-        if (!CalculateXTransformation (theRect)) {
-          return false;
-        }
+        {
+          StageTimer theTimer (mProfile, RenderProfile::kTransforms);
+          if (!CalculateXTransformation (inRect)) {
+            return false;
+          }
 
-        if (!CalculateYTransformation (theRect)) {
-          return false;
+          if (!CalculateYTransformation (inRect)) {
+            return false;
+          }
+          mStageCounts.mTransforms++;
         }
         if (theRepeatCount>1) {
           break;
         }
         // hooks for some final calculations
         //bool theShouldRepeat = false;
+        StageTimer theTimer (mModifyingCalculatorList.empty () ? nullptr : mProfile, RenderProfile::kCalculators);
         for (PCalculator::tList::iterator theModifyingC=mModifyingCalculatorList.begin ();theModifyingC!=mModifyingCalculatorList.end();theModifyingC++) {
           PCalculator *theModifyingCalculator = *theModifyingC;
           if (theModifyingCalculator->ShouldCalculate ()) {
@@ -1025,74 +2132,390 @@ namespace SVGChart {
     //    theShouldRepeat = mModifyingCalculatorList.size ()>0;
       }
 
-      // hooks for some final calculations
-      for (PCalculator::tList::iterator thePostC=mPostCalculatorList.begin ();thePostC!=mPostCalculatorList.end();thePostC++) {
-        PCalculator *thePostCalculator = *thePostC;
-        thePostCalculator->Calculate (inPainter, *this);
-      }
+      return true;
+    }
 
-      for (PDrawer::tList::iterator thePre1=mPreDrawerList.begin();thePre1!=mPreDrawerList.end ();thePre1++) {
-        PDrawer *thePreDrawer = *thePre1;
-        thePreDrawer->Prepare (inPainter, *this);
+    bool IsSameStyle (const PStyle &inA, const PStyle &inB) {
+      return inA.mFontSize == inB.mFontSize && inA.mFont == inB.mFont &&
+        inA.mPenWidth == inB.mPenWidth && inA.mPenStyle == inB.mPenStyle && inA.mVar == inB.mVar;
+    }
+
+    bool IsSameTickInfo (const TickInfo &inA, const TickInfo &inB) {
+      return inA.mAutoTick == inB.mAutoTick && inA.mAutoTickSize == inB.mAutoTickSize &&
+        inA.mTicksOn == inB.mTicksOn && inA.mTickDivision == inB.mTickDivision &&
+        inA.mMajorTickSpan == inB.mMajorTickSpan && inA.mMajorTickScreenSize == inB.mMajorTickScreenSize &&
+        inA.mMinorTickScreenSize == inB.mMinorTickScreenSize && inA.mFormatString == inB.mFormatString &&
+        inA.mLabelAngle == inB.mLabelAngle && IsSameStyle (inA.mStyle, inB.mStyle);
+    }
+
+    bool IsSameAxisSetup (const AxisSetup &inA, const AxisSetup &inB) {
+      return inA.mMin == inB.mMin && inA.mMax == inB.mMax &&
+        inA.mAutoScaleMin == inB.mAutoScaleMin && inA.mAutoScaleMax == inB.mAutoScaleMax &&
+        inA.mAscending == inB.mAscending && inA.mLogScale == inB.mLogScale &&
+        inA.mCrossOrigin == inB.mCrossOrigin && inA.mMaxDecades == inB.mMaxDecades &&
+        inA.mLogFactor == inB.mLogFactor && inA.mLogBase == inB.mLogBase &&
+        inA.mTimeScale == inB.mTimeScale && inA.mTimeOrigin == inB.mTimeOrigin &&
+        inA.mTimeUnit == inB.mTimeUnit && inA.mLabel == inB.mLabel &&
+        inA.mLabelElide == inB.mLabelElide && IsSameStyle (inA.mStyle, inB.mStyle) &&
+        IsSameTickInfo (inA.mTickInfo, inB.mTickInfo);
+    }
+
+    static bool IsSameSharedRange (const PPlot::SharedRange &inA, const PPlot::SharedRange &inB) {
+      return inA.mSet == inB.mSet && (!inA.mSet || (inA.mMin == inB.mMin && inA.mMax == inB.mMax));
+    }
+
+    int PPlot::GetDirtyFlags (Painter &inPainter) const {
+      // modifying calculators may change anything, so they always get a full layout
+      if (!mLayout.mValid || !mModifyingCalculatorList.empty ()) {
+        return kDataDirty | kAxisDirty | kMarginsDirty | kPainterDirty;
+      }
+      int theFlags = 0;
+      long thePlotCount = mPlotDataContainer.GetPlotCount ();
+      if (mPlotDataContainer.GetGeneration () != mLayout.mDataGeneration || 2*thePlotCount != (long)mLayout.mDataSizes.size ()) {
+        theFlags |= kDataDirty;
+      }
+      else {
+        // appended points are seen, changed values are not
+        for (int theI=0;theI<thePlotCount;theI++) {
+          if (mPlotDataContainer.GetConstXData (theI)->GetSize () != mLayout.mDataSizes[2*theI] ||
+              mPlotDataContainer.GetConstYData (theI)->GetSize () != mLayout.mDataSizes[2*theI+1]) {
+            theFlags |= kDataDirty;
+            break;
+          }
+        }
+      }
+      if (!IsSameAxisSetup (mXAxisSetup, mLayout.mXOutput) || !IsSameAxisSetup (mYAxisSetup, mLayout.mYOutput)) {
+        theFlags |= kAxisDirty;
+      }
+      if (mMargins.mLeft != mLayout.mMargins.mLeft || mMargins.mRight != mLayout.mMargins.mRight ||
+          mMargins.mTop != mLayout.mMargins.mTop || mMargins.mBottom != mLayout.mMargins.mBottom) {
+        theFlags |= kMarginsDirty;
       }
+      // tick spacing follows the text size
+      if (inPainter.GetWidth () != mLayout.mPainterWidth || inPainter.GetHeight () != mLayout.mPainterHeight ||
+          inPainter.GetFontHeight () != mLayout.mFontHeight || inPainter.CalculateTextDrawSize ("12345") != mLayout.mTextWidth) {
+        theFlags |= kPainterDirty;
+      }
+      // another member of the group may have changed the common range
+      if (mXAxisGroup && mXAxisGroup->GetVersion () != mLayout.mXAxisGroupVersion) {
+        theFlags |= kDataDirty;
+      }
+      if (!IsSameSharedRange (mSharedXRange, mLayout.mSharedXRange) || !IsSameSharedRange (mSharedYRange, mLayout.mSharedYRange)) {
+        theFlags |= kDataDirty;
+      }
+      return theFlags;
+    }
 
-      // Drawing !
+    void PPlot::StoreLayoutInputs (Painter &inPainter) {
+      mLayout.mValid = false;
+      long thePlotCount = mPlotDataContainer.GetPlotCount ();
+      mLayout.mDataGeneration = mPlotDataContainer.GetGeneration ();
+      mLayout.mDataSizes.resize (2*thePlotCount);
+      for (int theI=0;theI<thePlotCount;theI++) {
+        mLayout.mDataSizes[2*theI] = mPlotDataContainer.GetConstXData (theI)->GetSize ();
+        mLayout.mDataSizes[2*theI+1] = mPlotDataContainer.GetConstYData (theI)->GetSize ();
+      }
+      mLayout.mMargins = mMargins;
+      mLayout.mPainterWidth = inPainter.GetWidth ();
+      mLayout.mPainterHeight = inPainter.GetHeight ();
+      mLayout.mFontHeight = inPainter.GetFontHeight ();
+      mLayout.mTextWidth = inPainter.CalculateTextDrawSize ("12345");
+      mLayout.mXAxisGroupVersion = mXAxisGroup ? mXAxisGroup->GetVersion () : 0;
+      mLayout.mSharedXRange = mSharedXRange;
+      mLayout.mSharedYRange = mSharedYRange;
+    }
 
-      inPainter.SetLineColor (0,0,0);
-      inPainter.SetClipRect (0, 0, inPainter.GetWidth (), inPainter.GetHeight ());
+    static inline uint64_t MixHashWord (uint64_t inState, uint64_t inWord) {
+      return ((inState << 23 | inState >> 41) ^ inWord) * 0x9E3779B97F4A7C15ULL;
+    }
 
-      // draw entire background, including the margins (for scrolling...)
-      PRect fullRect;
-      fullRect.mX = 0;
-      fullRect.mY = 0;
-      fullRect.mW = inPainter.GetWidth ();
-      fullRect.mH = inPainter.GetHeight ();
-      if (!DrawPlotBackground (fullRect, inPainter)) {
-        return false;
+    void ContentHasher::AddBytes (const void *inData, size_t inSize) {
+      const unsigned char *theBytes = static_cast<const unsigned char *>(inData);
+      mLength += inSize;
+      while (inSize >= 8) {
+        uint64_t theWord;
+        memcpy (&theWord, theBytes, 8);
+        mState = MixHashWord (mState, theWord);
+        theBytes += 8;
+        inSize -= 8;
+      }
+      if (inSize > 0) {
+        uint64_t theWord = 0;
+        memcpy (&theWord, theBytes, inSize);
+        mState = MixHashWord (mState, theWord ^ (uint64_t)inSize << 56);
       }
+    }
 
-      for (PDrawer::tList::iterator thePre=mPreDrawerList.begin ();thePre!=mPreDrawerList.end();thePre++) {
-        PDrawer *thePreDrawer = *thePre;
-        thePreDrawer->Draw (inPainter);
+    void ContentHasher::AddString (const string &inString) {
+      AddLong (inString.size ());
+      AddBytes (inString.data (), inString.size ());
+    }
+
+    void ContentHasher::AddStyle (const PStyle &inStyle) {
+      AddLong (inStyle.mFontSize);
+      AddString (inStyle.mFont);
+      AddLong (inStyle.mPenWidth);
+      AddString (inStyle.mPenStyle);
+      AddLong (inStyle.mVar.size ());
+      for (const auto &theVar : inStyle.mVar) {
+        AddString (theVar.first);
+        AddString (theVar.second);
       }
+    }
 
+    uint64_t ContentHasher::GetHash () const {
+      // final avalanche, so nearby inputs give unrelated hashes
+      uint64_t theHash = mState ^ mLength;
+      theHash ^= theHash >> 33;
+      theHash *= 0xFF51AFD7ED558CCDULL;
+      theHash ^= theHash >> 33;
+      theHash *= 0xC4CEB9FE1A85EC53ULL;
+      theHash ^= theHash >> 33;
+      return theHash;
+    }
 
-      if (!DrawGridXAxis (theRect, inPainter)) {
-        return false;
+    void DataDrawerBase::AddBaseToHash (ContentHasher &ioHasher) const {
+      ioHasher.AddString (typeid (*this).name ());
+      ioHasher.AddLong (mDrawFast);
+    }
+
+    static void AddColorToHash (const PColor &inColor, ContentHasher &ioHasher) {
+      ioHasher.AddLong (inColor.mR << 16 | inColor.mG << 8 | inColor.mB);
+    }
+
+    static void AddDataToHash (const PlotDataBase &inData, ContentHasher &ioHasher) {
+      PlotDataSpan theSpan = inData.GetSpan ();
+      long theSize = theSpan.GetSize ();
+      ioHasher.AddLong (theSize);
+      if (theSpan.mData) {
+        ioHasher.AddBytes (theSpan.mData, theSize*sizeof (float));
       }
-      
-      if (!DrawGridYAxis (theRect, inPainter)) {
-        return false;
+      else {
+        // gathered in blocks, so the hasher still takes 8 bytes per step
+        float theBlock[256];
+        for (long theStart=0;theStart<theSize;theStart+=256) {
+          long theCount = PMin (theSize-theStart, 256L);
+          for (long theI=0;theI<theCount;theI++) {
+            theBlock[theI] = theSpan[theStart+theI];
+          }
+          ioHasher.AddBytes (theBlock, theCount*sizeof (float));
+        }
       }
-      
-      if (!DrawXAxis (theRect, inPainter)) {
-        return false;
+      const StringData *theStringData = dynamic_cast<const StringData *>(&inData);
+      if (theStringData) {
+        for (const string &theString : *theStringData->GetStringData ()) {
+          ioHasher.AddString (theString);
+        }
       }
+    }
 
-      if (!DrawYAxis (theRect, inPainter)) {
+    // inCrossOrigin is passed separately: ConfigureSelf turns it off next to
+    // log and time axes, and the hash must not change by drawing
+    static void AddAxisSetupToHash (const AxisSetup &inAxisSetup, bool inCrossOrigin, ContentHasher &ioHasher) {
+      ioHasher.AddFloat (inAxisSetup.mMin);
+      ioHasher.AddFloat (inAxisSetup.mMax);
+      ioHasher.AddLong (inAxisSetup.mAutoScaleMin);
+      ioHasher.AddLong (inAxisSetup.mAutoScaleMax);
+      ioHasher.AddLong (inAxisSetup.mAscending);
+      ioHasher.AddLong (inAxisSetup.mLogScale);
+      ioHasher.AddLong (inCrossOrigin);
+      ioHasher.AddLong (inAxisSetup.mMaxDecades);
+      ioHasher.AddLong (inAxisSetup.mLogFactor);
+      ioHasher.AddFloat (inAxisSetup.mLogBase);
+      ioHasher.AddLong (inAxisSetup.mTimeScale);
+      ioHasher.AddDouble (inAxisSetup.mTimeOrigin);
+      ioHasher.AddDouble (inAxisSetup.mTimeUnit);
+      ioHasher.AddString (inAxisSetup.mLabel);
+      ioHasher.AddLong (inAxisSetup.mLabelElide);
+      ioHasher.AddStyle (inAxisSetup.mStyle);
+      const TickInfo &theTickInfo = inAxisSetup.mTickInfo;
+      ioHasher.AddLong (theTickInfo.mAutoTick);
+      ioHasher.AddLong (theTickInfo.mAutoTickSize);
+      ioHasher.AddLong (theTickInfo.mTicksOn);
+      ioHasher.AddLong (theTickInfo.mTickDivision);
+      ioHasher.AddFloat (theTickInfo.mMajorTickSpan);
+      ioHasher.AddLong (theTickInfo.mMajorTickScreenSize);
+      ioHasher.AddLong (theTickInfo.mMinorTickScreenSize);
+      ioHasher.AddString (theTickInfo.mFormatString);
+      ioHasher.AddFloat (theTickInfo.mLabelAngle);
+      ioHasher.AddStyle (theTickInfo.mStyle);
+    }
+
+    bool PPlot::GetContentHash (uint64_t &outHash) const {
+      if (mPPlotDrawer || mXAxisGroup || !mPreDrawerList.empty () || !mPostDrawerList.empty () ||
+          !mModifyingCalculatorList.empty () || !mPostCalculatorList.empty ()) {
         return false;
       }
+      ContentHasher theHasher;
+
+      // after a Draw the axis setups hold its results, hash what it started from
+      bool theDrawn = mLayout.mValid && IsSameAxisSetup (mXAxisSetup, mLayout.mXOutput) && IsSameAxisSetup (mYAxisSetup, mLayout.mYOutput);
+      const AxisSetup &theXAxisSetup = theDrawn ? mLayout.mXInput : mXAxisSetup;
+      const AxisSetup &theYAxisSetup = theDrawn ? mLayout.mYInput : mYAxisSetup;
+      bool theXCross = theXAxisSetup.mCrossOrigin && !theYAxisSetup.mLogScale && !theYAxisSetup.mTimeScale;
+      bool theYCross = theYAxisSetup.mCrossOrigin && !theXAxisSetup.mLogScale && !theXAxisSetup.mTimeScale;
+      AddAxisSetupToHash (theXAxisSetup, theXCross, theHasher);
+      AddAxisSetupToHash (theYAxisSetup, theYCross, theHasher);
+      // unset ranges add nothing, so plots outside a grid hash as before
+      if (mSharedXRange.mSet) {
+        theHasher.AddString ("shared x");
+        theHasher.AddFloat (mSharedXRange.mMin);
+        theHasher.AddFloat (mSharedXRange.mMax);
+      }
+      if (mSharedYRange.mSet) {
+        theHasher.AddString ("shared y");
+        theHasher.AddFloat (mSharedYRange.mMin);
+        theHasher.AddFloat (mSharedYRange.mMax);
+      }
+
+      theHasher.AddLong (mGridInfo.mXGridOn);
+      theHasher.AddLong (mGridInfo.mYGridOn);
+      theHasher.AddLong (mMargins.mLeft);
+      theHasher.AddLong (mMargins.mRight);
+      theHasher.AddLong (mMargins.mTop);
+      theHasher.AddLong (mMargins.mBottom);
+      theHasher.AddLong (mPlotBackground.mTransparent);
+      AddColorToHash (mPlotBackground.mPlotRegionBackColor, theHasher);
+      theHasher.AddString (mPlotBackground.mTitle);
+      theHasher.AddLong (mPlotBackground.mTitleElide);
+      theHasher.AddStyle (mPlotBackground.mStyle);
+      theHasher.AddLong (mLegendSetup.mUsePlotRect);
+      theHasher.AddLong (mLegendSetup.mBox.mX);
+      theHasher.AddLong (mLegendSetup.mBox.mY);
+      theHasher.AddLong (mLegendSetup.mBox.mW);
+      theHasher.AddLong (mLegendSetup.mBox.mH);
+      theHasher.AddLong (mLegendSetup.mXOffset);
+      theHasher.AddLong (mLegendSetup.mColumnGap);
+      theHasher.AddLong (mLegendSetup.mMaxColumns);
+      theHasher.AddLong (mLegendSetup.mDrawSwatches);
+      theHasher.AddLong (mLegendSetup.mElide);
+
+      int thePlotCount = mPlotDataContainer.GetPlotCount ();
+      theHasher.AddLong (thePlotCount);
+      for (int theI=0;theI<thePlotCount;theI++) {
+        AddDataToHash (*mPlotDataContainer.GetConstXData (theI), theHasher);
+        AddDataToHash (*mPlotDataContainer.GetConstYData (theI), theHasher);
+        const LegendData *theLegendData = mPlotDataContainer.GetConstLegendData (theI);
+        theHasher.AddString (theLegendData->mName);
+        AddColorToHash (theLegendData->mColor, theHasher);
+        theHasher.AddLong (theLegendData->mShow);
+        theHasher.AddStyle (theLegendData->mStyle);
+        const DataDrawerBase *theDataDrawer = mPlotDataContainer.GetConstDataDrawer (theI);
+        if (!theDataDrawer->AddToHash (theHasher)) {
+          return false;
+        }
+        const PlotDataSelection *theSelection = mPlotDataContainer.GetConstPlotDataSelection (theI);
+        theHasher.AddLong (theSelection->size ());
+        theHasher.AddBytes (theSelection->data (), theSelection->size ()*sizeof (int));
+      }
+      outHash = theHasher.GetHash ();
+      return true;
+    }
 
-      if (!DrawLegend (theRect, inPainter)) {
-        return false;
+    AxisGroup::~AxisGroup () {
+      for (PPlot *thePPlot : mPlotList) {
+        thePPlot->mXAxisGroup = nullptr;
+        thePPlot->SetDataChanged ();
       }
+    }
 
-      // clip the plotregion while drawing plots
-      inPainter.SetClipRect (theRect.mX, theRect.mY, theRect.mW, theRect.mH);
+    void AxisGroup::AddPlot (PPlot *inPPlot) {
+      if (!inPPlot || inPPlot->mXAxisGroup == this) {
+        return;
+      }
+      if (inPPlot->mXAxisGroup) {
+        inPPlot->mXAxisGroup->RemovePlot (inPPlot);
+      }
+      mPlotList.push_back (inPPlot);
+      inPPlot->mXAxisGroup = this;
+      mDataChanged = true;
+    }
 
+    void AxisGroup::RemovePlot (PPlot *inPPlot) {
+      vector<PPlot *>::iterator theFound = find (mPlotList.begin (), mPlotList.end (), inPPlot);
+      if (theFound == mPlotList.end ()) {
+        return;
+      }
+      mPlotList.erase (theFound);
+      inPPlot->mXAxisGroup = nullptr;
+      // its layout holds the group's range
+      inPPlot->SetDataChanged ();
+      mDataChanged = true;
+    }
+
+    void AxisGroup::SetDataChanged () {
+      std::lock_guard<mutex> theLock (mLock);
+      mDataChanged = true;
+    }
 
-      for (int theI=0;theI<mPlotDataContainer.GetPlotCount ();theI++) {
-        if (!DrawPlot (theI, theRect, inPainter)) {
+    long AxisGroup::GetVersion () {
+      std::lock_guard<mutex> theLock (mLock);
+      return UpdateVersion ();
+    }
+
+    long AxisGroup::UpdateVersion () {
+      // appended points are seen, changed values need SetDataChanged
+      vector<long> theDataState;
+      for (const PPlot *thePPlot : mPlotList) {
+        const PlotDataContainer &theContainer = thePPlot->mPlotDataContainer;
+        theDataState.push_back (theContainer.GetGeneration ());
+        theDataState.push_back (theContainer.GetPlotCount ());
+        for (int theI=0;theI<theContainer.GetPlotCount ();theI++) {
+          theDataState.push_back (theContainer.GetConstXData (theI)->GetSize ());
+        }
+      }
+      if (mDataChanged || theDataState != mDataState) {
+        mDataState.swap (theDataState);
+        mDataChanged = false;
+        mHasRange = false;
+        mHasTicks = false;
+        mVersion++;
+      }
+      return mVersion;
+    }
+
+    bool AxisGroup::GetRange (float &outMin, float &outMax) {
+      std::lock_guard<mutex> theLock (mLock);
+      UpdateVersion ();
+      if (!mHasRange) {
+        mRangeScans++;
+        bool theFirst = true;
+        for (const PPlot *thePPlot : mPlotList) {
+          float theMin, theMax;
+          if (!thePPlot->mPlotDataContainer.GetPlotCount () || !thePPlot->mPlotDataContainer.CalculateXRange (theMin, theMax)) {
+            continue;
+          }
+          mMin = theFirst ? theMin : PMin (mMin, theMin);
+          mMax = theFirst ? theMax : PMax (mMax, theMax);
+          theFirst = false;
+        }
+        if (theFirst) {
           return false;
         }
+        mHasRange = true;
       }
+      outMin = mMin;
+      outMax = mMax;
+      return true;
+    }
 
-      for (PDrawer::tList::iterator thePost=mPostDrawerList.begin ();thePost!=mPostDrawerList.end();thePost++) {
-        PDrawer *thePostDrawer = *thePost;
-        thePostDrawer->Draw (inPainter);
+    bool AxisGroup::GetTicks (const AxisSetup &inAxisSetup, long inLength, TickList &outTickList) {
+      std::lock_guard<mutex> theLock (mLock);
+      UpdateVersion ();
+      if (!mHasTicks || inLength != mTickLength || !IsSameAxisSetup (inAxisSetup, mTickAxisSetup)) {
+        return false;
       }
+      outTickList = mTickList;
+      return true;
+    }
 
-      return true;
+    void AxisGroup::StoreTicks (const AxisSetup &inAxisSetup, long inLength, const TickList &inTickList) {
+      std::lock_guard<mutex> theLock (mLock);
+      mTickAxisSetup = inAxisSetup;
+      mTickLength = inLength;
+      mTickList = inTickList;
+      mHasTicks = true;
+      mTickFills++;
     }
 
     void PPlot::SetPPlotDrawer (PDrawer *inPDrawer) {
@@ -1108,6 +2531,68 @@ namespace SVGChart {
       mPPlotDrawer = &inPDrawer;
     }
 
+    const PlotSpatialIndex * PPlot::GetSpatialIndex (int inPlotIndex) const {
+      if (inPlotIndex < 0 || inPlotIndex >= (int)mSpatialIndexList.size ()) {
+        return nullptr;// not drawn yet
+      }
+      PlotSpatialIndex &theIndex = mSpatialIndexList[inPlotIndex];
+      if (!theIndex.IsBuilt ()) {
+        const PlotDataBase *theXData = mPlotDataContainer.GetConstXData (inPlotIndex);
+        const PlotDataBase *theYData = mPlotDataContainer.GetConstYData (inPlotIndex);
+        if (!theXData || !theYData) {
+          return nullptr;
+        }
+        theIndex.Build (*theXData, *theYData, *mXTrafo, *mYTrafo, mPlotRect);
+      }
+      return &theIndex;
+    }
+
+    bool PPlot::FindNearestPoint (float inScreenX, float inScreenY, float inMaxDistance, int &outPlotIndex, long &outPointIndex) const {
+      outPlotIndex = -1;
+      outPointIndex = -1;
+      float theBestDistance = inMaxDistance;
+      for (int theI=0;theI<(int)mSpatialIndexList.size ();theI++) {
+        const PlotSpatialIndex *theIndex = GetSpatialIndex (theI);
+        if (!theIndex) {
+          continue;
+        }
+        float theDistance;
+        long thePoint = theIndex->FindNearest (inScreenX, inScreenY, theBestDistance, theDistance);
+        if (thePoint >= 0 && (outPlotIndex < 0 || theDistance < theBestDistance)) {
+          theBestDistance = theDistance;
+          outPlotIndex = theI;
+          outPointIndex = thePoint;
+        }
+      }
+      return outPlotIndex >= 0;
+    }
+
+    bool PPlot::FindPointsInRect (int inPlotIndex, const PRect &inScreenRect, vector<long> &outPointIndices) const {
+      const PlotSpatialIndex *theIndex = GetSpatialIndex (inPlotIndex);
+      if (!theIndex) {
+        outPointIndices.clear ();
+        return false;
+      }
+      theIndex->FindInRect (inScreenRect, outPointIndices);
+      return true;
+    }
+
+    bool PPlot::SelectPointsInRect (int inPlotIndex, const PRect &inScreenRect) {
+      PlotDataSelection *theSelection = mPlotDataContainer.GetPlotDataSelection (inPlotIndex);
+      const PlotDataBase *theYData = mPlotDataContainer.GetConstYData (inPlotIndex);
+      vector<long> thePoints;
+      if (!theSelection || !theYData || !FindPointsInRect (inPlotIndex, inScreenRect, thePoints)) {
+        return false;
+      }
+      if ((long)theSelection->size () < theYData->GetSize ()) {
+        theSelection->resize (theYData->GetSize ());
+      }
+      for (long thePoint : thePoints) {
+        (*theSelection)[thePoint] = 1;
+      }
+      return true;
+    }
+
     bool PPlot::DrawPlotBackground (const PRect &inRect, Painter &inPainter) const {
       inPainter.SetStyle (mPlotBackground.mStyle);
 
@@ -1118,6 +2603,7 @@ namespace SVGChart {
       }
       string theTitle = mPlotBackground.mTitle;
       if (theTitle.size ()>0) {
+        theTitle = ElideText (theTitle, inRect.mW, mPlotBackground.mTitleElide, inPainter);
         int theW = inPainter.CalculateTextDrawSize (theTitle.c_str ());
         int theX = Round (inRect.mX + (inRect.mW-theW)*0.5);
         int theY = inRect.mY - inPainter.GetFontHeight ()+mMargins.mTop;
@@ -1131,23 +2617,16 @@ namespace SVGChart {
 
       // ticks
       inPainter.SetStyle (mXAxisSetup.mTickInfo.mStyle);
-      if (!mXTickIterator->Init ()) {
-        return false;
-      }
-
-      float theX;
-      bool theIsMajorTick;
-      string theFormatString;
 
       inPainter.SetFillColor (200,200,200);
       inPainter.SetLineColor (200,200,200);
 
       // draw gridlines
       if (mGridInfo.mXGridOn) {
-          while (mXTickIterator->GetNextTick (theX, theIsMajorTick, theFormatString)) {
-
-              if (theIsMajorTick && mGridInfo.mXGridOn) {
-                  float theScreenX = mXTrafo->Transform(theX);
+          for (long theI=0; theI<mXTickList.GetCount (); theI++) {
+              const TickList::Tick &theTick = mXTickList.GetTick (theI);
+              if (theTick.mIsMajor && mGridInfo.mXGridOn) {
+                  float theScreenX = mXTrafo->Transform(theTick.mValue);
                   inPainter.DrawLine (theScreenX, inRect.mY, theScreenX, inRect.mY + inRect.mH);
               }
           }
@@ -1163,24 +2642,16 @@ namespace SVGChart {
         
         // ticks
         inPainter.SetStyle (mYAxisSetup.mTickInfo.mStyle);
-        if (!mYTickIterator->Init ()) {
-            return false;
-        }
-        
-        float theY;
-        bool theIsMajorTick;
-        string theFormatString;
-        PRect theTickRect;
 
         inPainter.SetFillColor (200,200,200);
         inPainter.SetLineColor (200,200,200);
         
         // draw gridlines
         if (mYAxisSetup.mTickInfo.mTicksOn) {
-            while (mYTickIterator->GetNextTick (theY, theIsMajorTick, theFormatString)) {
-
-                if (theIsMajorTick && mGridInfo.mYGridOn) {
-                    float theScreenY = mYTrafo->Transform(theY);
+            for (long theI=0; theI<mYTickList.GetCount (); theI++) {
+                const TickList::Tick &theTick = mYTickList.GetTick (theI);
+                if (theTick.mIsMajor && mGridInfo.mYGridOn) {
+                    float theScreenY = mYTrafo->Transform(theTick.mValue);
                     inPainter.DrawLine (inRect.mX, theScreenY, inRect.mX + inRect.mW, theScreenY);
                 }
             }
@@ -1213,21 +2684,15 @@ namespace SVGChart {
 
       // ticks
       inPainter.SetStyle (mXAxisSetup.mTickInfo.mStyle);
-      if (!mXTickIterator->Init ()) {
-        return false;
-      }
-
-      float theX;
-      bool theIsMajorTick;
-      string theFormatString;
 
       int theYMax = 0;
       PRect theTickRect;
       PRect theRect = inRect;
 
       if (mXAxisSetup.mTickInfo.mTicksOn) {
-          while (mXTickIterator->GetNextTick (theX, theIsMajorTick, theFormatString)) {
-              if (!DrawXTick (theX, theY1, theIsMajorTick, theFormatString, inPainter, theTickRect)) {
+          for (long theI=0; theI<mXTickList.GetCount (); theI++) {
+              const TickList::Tick &theTick = mXTickList.GetTick (theI);
+              if (!DrawXTick (theTick.mValue, theY1, theTick.mIsMajor, mXTickList.GetLabel (theI), inPainter, theTickRect)) {
                   return false;
               }
               
@@ -1244,6 +2709,7 @@ namespace SVGChart {
       inPainter.SetStyle (mXAxisSetup.mStyle);
       string theLabel = mXAxisSetup.mLabel;
       if (theLabel.size ()>0) {
+        theLabel = ElideText (theLabel, theRect.mW, mXAxisSetup.mLabelElide, inPainter);
         int theW = inPainter.CalculateTextDrawSize (theLabel.c_str ());
         int theX = theRect.mX + (theRect.mW-theW)/2;
         int theY = theRect.mY+theRect.mH+inPainter.GetFontHeight ();
@@ -1252,8 +2718,7 @@ namespace SVGChart {
       return true;
     }
 
-    bool PPlot::DrawXTick (float inX, int inScreenY, bool inMajor, const string &inFormatString, Painter &inPainter, PRect &outRect) const{
-      char theBuf[128];
+    bool PPlot::DrawXTick (float inX, int inScreenY, bool inMajor, const char *inLabel, Painter &inPainter, PRect &outRect) const{
       int theTickSize;
       float theScreenX = mXTrafo->Transform(inX);
       outRect.mX = theScreenX;
@@ -1261,10 +2726,24 @@ namespace SVGChart {
       outRect.mW = 0;
       if (inMajor) {
         theTickSize = mXAxisSetup.mTickInfo.mMajorTickScreenSize;
-        snprintf (theBuf, 128, inFormatString.c_str (), inX);
 
-        outRect.mH = inPainter.GetFontHeight ()+theTickSize + mXAxisSetup.mTickInfo.mMinorTickScreenSize;;
-        inPainter.DrawText (theScreenX, inScreenY+outRect.mH, theBuf);
+        float theAngle = mXAxisSetup.mTickInfo.mLabelAngle;
+        if (theAngle == 0) {
+          outRect.mH = inPainter.GetFontHeight ()+theTickSize + mXAxisSetup.mTickInfo.mMinorTickScreenSize;;
+          inPainter.DrawText (theScreenX, inScreenY+outRect.mH, inLabel);
+        }
+        else {
+          // the end of the label sits below the tick
+          float theCos = cos (theAngle*kPi/180);
+          float theSin = sin (theAngle*kPi/180);
+          float theWidth = inPainter.CalculateTextDrawSize (inLabel);
+          float theHeight = inPainter.GetFontHeight ();
+          float theEndY = inScreenY+theTickSize+mXAxisSetup.mTickInfo.mMinorTickScreenSize;
+          outRect.mH = Round (theEndY-inScreenY+theWidth*fabs (theSin)+theHeight*fabs (theCos));
+          int theX = Round (theScreenX-theWidth*theCos+theHeight*0.5f*fabs (theSin));
+          int theY = Round (theEndY-theWidth*theSin);
+          inPainter.DrawRotatedText (theX, theY, theAngle, inLabel);
+        }
       }
       else {
         theTickSize = mXAxisSetup.mTickInfo.mMinorTickScreenSize;
@@ -1299,18 +2778,13 @@ namespace SVGChart {
 
       // ticks
       inPainter.SetStyle (mYAxisSetup.mTickInfo.mStyle);
-      if (!mYTickIterator->Init ()) {
-        return false;
-      }
 
-      float theY;
-      bool theIsMajorTick;
-      string theFormatString;
       PRect theTickRect;
 
       if (mYAxisSetup.mTickInfo.mTicksOn) {
-          while (mYTickIterator->GetNextTick (theY, theIsMajorTick, theFormatString)) {
-              if (!DrawYTick (theY, theX1, theIsMajorTick, theFormatString, inPainter, theTickRect)) {
+          for (long theI=0; theI<mYTickList.GetCount (); theI++) {
+              const TickList::Tick &theTick = mYTickList.GetTick (theI);
+              if (!DrawYTick (theTick.mValue, theX1, theTick.mIsMajor, mYTickList.GetLabel (theI), inPainter, theTickRect)) {
                   return false;
               }
 
@@ -1324,6 +2798,7 @@ namespace SVGChart {
       inPainter.SetStyle (mYAxisSetup.mStyle);
       string theLabel = mYAxisSetup.mLabel;
       if (theLabel.size ()>0) {
+        theLabel = ElideText (theLabel, theRect.mH, mYAxisSetup.mLabelElide, inPainter);
         int theW = inPainter.CalculateTextDrawSize (theLabel.c_str ());
         int theX = theRect.mX;
         int theY = theRect.mY + theRect.mH - (theRect.mH-theW)/2;
@@ -1333,8 +2808,7 @@ namespace SVGChart {
       return true;
     }
 
-    bool PPlot::DrawYTick (float inY, int inScreenX, bool inMajor, const string &inFormatString, Painter &inPainter, PRect &outRect) const {
-      char theBuf[128];
+    bool PPlot::DrawYTick (float inY, int inScreenX, bool inMajor, const char *inLabel, Painter &inPainter, PRect &outRect) const {
       int theTickSize;
       float theScreenY = mYTrafo->Transform(inY);
       outRect.mX = inScreenX;
@@ -1343,11 +2817,10 @@ namespace SVGChart {
       outRect.mH = 0;// not used
       if (inMajor) {
         theTickSize = mYAxisSetup.mTickInfo.mMajorTickScreenSize;
-        snprintf (theBuf, 128, inFormatString.c_str (), inY);
-        int theStringWidth = inPainter.CalculateTextDrawSize (theBuf);
+        int theStringWidth = inPainter.CalculateTextDrawSize (inLabel);
         outRect.mX -= (theStringWidth+theTickSize+mYAxisSetup.mTickInfo.mMinorTickScreenSize);
         int theHalfFontHeight = inPainter.GetFontHeight ()/2;// for sort of vertical centralizing
-        inPainter.DrawText (outRect.mX, theScreenY+theHalfFontHeight, theBuf);
+        inPainter.DrawText (outRect.mX, theScreenY+theHalfFontHeight, inLabel);
 
       }
       else {
@@ -1360,59 +2833,107 @@ namespace SVGChart {
     }
 
     bool PPlot::DrawLegend (const PRect &inRect, Painter &inPainter) const {
-        const int kXoffsetLegend(20);
-        
+        PRect theBox = mLegendSetup.mUsePlotRect ? inRect : mLegendSetup.mBox;
+        int theTextRoom = theBox.mW - mLegendSetup.mXOffset;
+
+        // measure every entry once
+        struct Entry {
+          int mPlotIndex;
+          string mText;
+          long mWidth;
+        };
+        vector<Entry> theEntries;
+        int theHeight = 0;
         for (int theI=0; theI<mPlotDataContainer.GetPlotCount (); theI++) {
-            PColor theC;
-            string theText;
             const LegendData *theLegendData = mPlotDataContainer.GetConstLegendData (theI);
-            if (theLegendData) {
-                inPainter.SetStyle (theLegendData->mStyle);
-                theC = theLegendData->mColor;
-                if (theLegendData->mShow) {
-                  theText = theLegendData->mName;
-                }
+            if (!theLegendData || !theLegendData->mShow || theLegendData->mName.empty ()) {
+                continue;
             }
-            inPainter.SetLineColor (theC.mR, theC.mG, theC.mB);
+            inPainter.SetStyle (theLegendData->mStyle);
+            // cut legend if it doesn't fit in the box
+            string theText = ElideText (theLegendData->mName, theTextRoom, mLegendSetup.mElide, inPainter);
+            long theWidth = inPainter.CalculateTextDrawSize (theText.c_str ());
+            theEntries.push_back ({theI, theText, theWidth});
+            theHeight = PMax (theHeight, (int)inPainter.GetFontHeight ());
+        }
+        if (theEntries.empty ()) {
+            return true;
+        }
 
-            // cut legend if it doesn't fit in plot
-            int theSize (0);
-            if (inPainter.CalculateTextDrawSize (theText.c_str ()) >= inRect.mW - kXoffsetLegend) {
-                theText.insert(0, "...");
-                while (inPainter.CalculateTextDrawSize (theText.c_str ()) >= inRect.mW - kXoffsetLegend) {
-                    theSize = theText.size ();
-                    // display dots and at least 3 characters
-                    if (theSize >= 9) {
-                        theText.erase (3, 3);
-                    }
-                    else if (theSize >= 7) {
-                        theText.erase (3, theSize - 6);
-                    } else {
-                        // keep dots only
-                        theText.erase (3, theSize - 3);
-                        break;
-                    }
-                }
+        // rows per column: the baseline of row i is at theBox.mY+i*2*theHeight+theHeight
+        long theRows = theBox.mH < theHeight ? 1 : (theBox.mH-theHeight)/(2*theHeight)+1;
+        long theCount = theEntries.size ();
+
+        // columns are filled top to bottom; add columns while they fit
+        vector<long> theColumnX;
+        long theX = theBox.mX + mLegendSetup.mXOffset;
+        for (long theStart=0; theStart<theCount; theStart+=theRows) {
+            long theColumnWidth = 0;
+            for (long theI=theStart; theI<PMin (theCount, theStart+theRows); theI++) {
+                theColumnWidth = PMax (theColumnWidth, theEntries[theI].mWidth);
             }
-            
-            int theHeight = inPainter.GetFontHeight ();
-            int theX = inRect.mX + kXoffsetLegend;
-            int theY = inRect.mY + theI*(theHeight*2)+theHeight;
-            inPainter.DrawText (theX, theY, theText.c_str ());
+            bool theFull = mLegendSetup.mMaxColumns > 0 && (long)theColumnX.size () >= mLegendSetup.mMaxColumns;
+            if (!theColumnX.empty () && (theFull || theX+theColumnWidth > theBox.mX+theBox.mW)) {
+                break;
+            }
+            theColumnX.push_back (theX);
+            theX += theColumnWidth + mLegendSetup.mColumnGap;
+        }
+        long theShown = PMin (theCount, (long)theColumnX.size ()*theRows);
+        long theHidden = theCount-theShown;
+        // the last slot tells how many did not fit, in the default style;
+        // drop columns until that text fits in the box, elide it in the first
+        string theMoreText;
+        const PStyle theMoreStyle;
+        while (theHidden > 0) {
+            theShown = (long)theColumnX.size ()*theRows-1;
+            theHidden = theCount-theShown;
+            inPainter.SetStyle (theMoreStyle);
+            theMoreText = "+" + std::to_string (theHidden) + " more";
+            long theMoreRoom = theBox.mX+theBox.mW-theColumnX.back ();
+            if (inPainter.CalculateTextDrawSize (theMoreText.c_str ()) <= theMoreRoom) {
+                break;
+            }
+            if (theColumnX.size () == 1) {
+                theMoreText = ElideText (theMoreText, theMoreRoom, kElideEnd, inPainter);
+                break;
+            }
+            theColumnX.pop_back ();
+        }
+
+        int theSwatchSize = PMax (1, theHeight/2);
+        for (long theI=0; theI<theShown; theI++) {
+            long theEntryX = theColumnX[theI/theRows];
+            long theY = theBox.mY + (theI%theRows)*(theHeight*2)+theHeight;
+            const LegendData *theLegendData = mPlotDataContainer.GetConstLegendData (theEntries[theI].mPlotIndex);
+            PColor theC = theLegendData->mColor;
+            inPainter.SetStyle (theLegendData->mStyle);
+            inPainter.SetLineColor (theC.mR, theC.mG, theC.mB);
+            if (mLegendSetup.mDrawSwatches) {
+                inPainter.SetFillColor (theC.mR, theC.mG, theC.mB);
+                inPainter.FillRect (theEntryX-theSwatchSize-4, theY-(theHeight+theSwatchSize)/2, theSwatchSize, theSwatchSize);
+            }
+            inPainter.DrawText (theEntryX, theY, theEntries[theI].mText.c_str ());
+        }
+        if (theHidden > 0) {
+            PColor theC;
+            inPainter.SetStyle (theMoreStyle);
+            inPainter.SetLineColor (theC.mR, theC.mG, theC.mB);
+            inPainter.DrawText (theColumnX[theShown/theRows], theBox.mY + (theShown%theRows)*(theHeight*2)+theHeight, theMoreText.c_str ());
         }
         return true;
     }
 
-    float GetMaxFromRange (const PlotDataBase &inData, long inStartIndex, long inEndIndex) {
+    float GetMaxFromRange (const PlotDataSpan &inData, long inStartIndex, long inEndIndex) {
         float max = 0;
         float fabsMax = 0;
         for (long theI = inStartIndex; theI <= inEndIndex; theI++) {
             if (theI == inStartIndex) {
-                max = inData.GetValue (theI);
+                max = inData[theI];
                 fabsMax = fabs (max);
             }
             else {
-                float data = inData.GetValue (theI);
+                float data = inData[theI];
                 if (fabs (data) > fabsMax) {
                     max = data;
                     fabsMax = fabs (data);
@@ -1423,9 +2944,9 @@ namespace SVGChart {
         return max;
     }
 
-    void FindRange (const PlotDataBase &inData, float inMin, float inMax, long& outStartIndex, long& outEndIndex) {
+    void FindRange (const PlotDataSpan &inData, float inMin, float inMax, long& outStartIndex, long& outEndIndex) {
         outStartIndex = 0;
-        while (outStartIndex < inData.GetSize () && inData.GetValue (outStartIndex) <= inMin) {
+        while (outStartIndex < inData.GetSize () && inData[outStartIndex] <= inMin) {
             outStartIndex++;
         }
 
@@ -1442,7 +2963,7 @@ namespace SVGChart {
         }
 
         outEndIndex = outStartIndex;
-        while (outEndIndex < inData.GetSize () && inData.GetValue (outEndIndex) < inMax) {
+        while (outEndIndex < inData.GetSize () && inData[outEndIndex] < inMax) {
             outEndIndex++;
         }
 
@@ -1452,15 +2973,148 @@ namespace SVGChart {
         assert (outStartIndex>-1);
     }
 
+    bool PolylineSimplifier::AddPoint (float inX, float inY, long inIndex, float &outX, float &outY, long &outIndex) {
+      if (!mHasAnchor) {
+        mHasAnchor = true;
+        mAnchorX = outX = inX;
+        mAnchorY = outY = inY;
+        outIndex = inIndex;
+        return true;
+      }
+      float theHalf = mTolerance*0.5f;
+      bool theEmitted = false;
+      if (mHasDirection) {
+        float theDX = inX-mAnchorX;
+        float theDY = inY-mAnchorY;
+        float theDistance = fabs (theDX*mDirY-theDY*mDirX);
+        float theProjection = theDX*mDirX+theDY*mDirY;
+        if (theDistance <= theHalf && theProjection >= mMaxProjection) {
+          mPendingX = inX;
+          mPendingY = inY;
+          mPendingIndex = inIndex;
+          mMaxProjection = theProjection;
+          return false;
+        }
+        // left the corridor: the pending point is a vertex and the new anchor
+        outX = mAnchorX = mPendingX;
+        outY = mAnchorY = mPendingY;
+        outIndex = mPendingIndex;
+        mHasDirection = false;
+        mHasPending = false;
+        theEmitted = true;
+      }
+
+      mPendingX = inX;
+      mPendingY = inY;
+      mPendingIndex = inIndex;
+      mHasPending = true;
+      float theDX = inX-mAnchorX;
+      float theDY = inY-mAnchorY;
+      float theLength = sqrt (theDX*theDX+theDY*theDY);
+      if (theLength > theHalf) {
+        // first point clear of the anchor defines the direction of the run
+        mDirX = theDX/theLength;
+        mDirY = theDY/theLength;
+        mMaxProjection = theLength;
+        mHasDirection = true;
+      }
+      return theEmitted;
+    }
+
+    bool PolylineSimplifier::Finish (float &outX, float &outY, long &outIndex) {
+      if (!mHasPending) {
+        return false;
+      }
+      outX = mPendingX;
+      outY = mPendingY;
+      outIndex = mPendingIndex;
+      mHasPending = false;
+      mHasDirection = false;
+      return true;
+    }
+
+    // Data accessors for the specialized line kernel: a plain float array and
+    // the affine CalculatedData case, both read without going through a span.
+    struct ContiguousLineData {
+      float operator[] (long inIndex) const {return mData[inIndex];}
+      const float *mData;
+    };
+
+    struct AffineLineData {
+      float operator[] (long inIndex) const {return mOffset + inIndex * mDelta;}
+      float mOffset;
+      float mDelta;
+    };
+
+    // The common LineDataDrawer case (no simplifier, no decimation, no selection)
+    // with the trafos, data layout and line/point flags fixed at compile time.
+    // The qualified Transform calls bind statically, so the loop has no virtual
+    // calls besides DrawPoint, and produces exactly what the generic loop does.
+    template <class XTrafo, class YTrafo, class XData, bool kDrawLine, bool kDrawPoint>
+    bool DrawLineKernel (const LineDataDrawer &inDrawer, const XTrafo &inXTrafo, const YTrafo &inYTrafo, const XData &inXData, const float *inYData, long inStart, long inEnd, const PRect &inRect, const PRect &inMarkerRect, Painter &inPainter) {
+      float thePrevX = 0;
+      float thePrevY = 0;
+      bool theFirst = true;
+      for (long theI = inStart; theI <= inEnd; theI++) {
+        float theTraX = inXTrafo.XTrafo::Transform (inXData[theI]);
+        float theTraY = inYTrafo.YTrafo::Transform (inYData[theI]);
+        if (kDrawLine) {
+          if (!theFirst) {
+            float theX1 = thePrevX, theY1 = thePrevY, theX2 = theTraX, theY2 = theTraY;
+            if (ClipLine (theX1, theY1, theX2, theY2, inRect)) {
+              inPainter.DrawLine (theX1, theY1, theX2, theY2);
+            }
+          }
+          theFirst = false;
+          thePrevX = theTraX;
+          thePrevY = theTraY;
+        }
+        if (kDrawPoint) {
+          bool theMarkerVisible = theTraX >= inMarkerRect.mX && theTraX <= inMarkerRect.mX+inMarkerRect.mW &&
+                                  theTraY >= inMarkerRect.mY && theTraY <= inMarkerRect.mY+inMarkerRect.mH;
+          if (theMarkerVisible && !inDrawer.DrawPoint (theTraX, theTraY, inRect, inPainter)) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    template <class XTrafo, class YTrafo, class XData>
+    bool DrawLineKernel (const LineDataDrawer &inDrawer, const XTrafo &inXTrafo, const YTrafo &inYTrafo, const XData &inXData, const float *inYData, long inStart, long inEnd, const PRect &inRect, const PRect &inMarkerRect, Painter &inPainter) {
+      if (inDrawer.mDrawLine && inDrawer.mDrawPoint) {
+        return DrawLineKernel<XTrafo, YTrafo, XData, true, true> (inDrawer, inXTrafo, inYTrafo, inXData, inYData, inStart, inEnd, inRect, inMarkerRect, inPainter);
+      }
+      if (inDrawer.mDrawLine) {
+        return DrawLineKernel<XTrafo, YTrafo, XData, true, false> (inDrawer, inXTrafo, inYTrafo, inXData, inYData, inStart, inEnd, inRect, inMarkerRect, inPainter);
+      }
+      if (inDrawer.mDrawPoint) {
+        return DrawLineKernel<XTrafo, YTrafo, XData, false, true> (inDrawer, inXTrafo, inYTrafo, inXData, inYData, inStart, inEnd, inRect, inMarkerRect, inPainter);
+      }
+      return true;
+    }
+
+    template <class YTrafo>
+    bool DrawLineKernel (const LineDataDrawer &inDrawer, const LinTrafo &inXTrafo, const YTrafo &inYTrafo, const PlotDataSpan &inXSpan, const float *inYData, long inStart, long inEnd, const PRect &inRect, const PRect &inMarkerRect, Painter &inPainter) {
+      if (inXSpan.mData) {
+        ContiguousLineData theXData{ inXSpan.mData };
+        return DrawLineKernel (inDrawer, inXTrafo, inYTrafo, theXData, inYData, inStart, inEnd, inRect, inMarkerRect, inPainter);
+      }
+      AffineLineData theXData{ inXSpan.mOffset, inXSpan.mDelta };
+      return DrawLineKernel (inDrawer, inXTrafo, inYTrafo, theXData, inYData, inStart, inEnd, inRect, inMarkerRect, inPainter);
+    }
+
     bool LineDataDrawer::DrawData (const PlotDataBase &inXData, const PlotDataBase &inYData, const PlotDataSelection &inPlotDataSelection, const AxisSetup &inXAxisSetup, const PRect &inRect, Painter &inPainter) const {
       if (!mXTrafo || !mYTrafo) {
         return false;
       }
-      if ((inXData.GetSize () == 0) || (inYData.GetSize () == 0)) {
+      PlotDataSpan theXSpan = inXData.GetSpan ();
+      PlotDataSpan theYSpan = inYData.GetSpan ();
+      if ((theXSpan.GetSize () == 0) || (theYSpan.GetSize () == 0)) {
           return false;
       }
-      long theXSize = inXData.GetSize ();
-      long theYSize = inYData.GetSize ();
+      long theXSize = theXSpan.GetSize ();
+      long theYSize = theYSpan.GetSize ();
       if (theXSize>theYSize) {
         return false;
       }
@@ -1470,11 +3124,36 @@ namespace SVGChart {
       bool theFirst = true;
       float theTraX, theTraY;
 
+      // line vertices pass through the optional simplifier, then get clipped
+      PolylineSimplifier theSimplifier (mSimplifyTolerance);
+      bool theSimplify = mDrawLine && mSimplifyTolerance > 0;
+      auto theEmitVertex = [&] (float inX, float inY) {
+        if (!theFirst) {
+          // segments outside the plot region are dropped, crossing ones end at the boundary
+          float theX1 = thePrevX, theY1 = thePrevY, theX2 = inX, theY2 = inY;
+          if (ClipLine (theX1, theY1, theX2, theY2, inRect)) {
+            inPainter.DrawLine (theX1, theY1, theX2, theY2);
+          }
+        }
+        theFirst = false;
+        thePrevX = inX;
+        thePrevY = inY;
+      };
+      float theVertexX, theVertexY;
+      long theVertexIndex;
+
+      // markers may stick out of the plot region by their size
+      PRect theMarkerRect = inRect;
+      theMarkerRect.mX -= kMarkerSize;
+      theMarkerRect.mY -= kMarkerSize;
+      theMarkerRect.mW += 2*kMarkerSize;
+      theMarkerRect.mH += 2*kMarkerSize;
+
       long theStart = 0;
-      long theEnd = inXData.GetSize () - 1;
+      long theEnd = theXSize - 1;
       int theStride = 1;
       if (mDrawFast) {
-          FindRange (inXData, inXAxisSetup.mMin, inXAxisSetup.mMax, theStart, theEnd);
+          FindRange (theXSpan, inXAxisSetup.mMin, inXAxisSetup.mMax, theStart, theEnd);
 
           theStride = (theEnd - theStart + 1) / inPainter.GetWidth ();
           if (theStride == 0) {
@@ -1482,37 +3161,55 @@ namespace SVGChart {
           }
       }
 
+      // the common cases run through a kernel specialized on trafos and flags
+      bool theXKernel = theXSpan.mData || !theXSpan.mCalculated;
+      bool theYKernel = theYSpan.mData != nullptr;
+      if (!theSimplify && theStride == 1 && theXKernel && theYKernel &&
+          typeid (*mXTrafo) == typeid (LinTrafo) && inPlotDataSelection.GetSelectedCount () == 0) {
+        const LinTrafo &theXTrafo = static_cast<const LinTrafo &>(*mXTrafo);
+        if (typeid (*mYTrafo) == typeid (LinTrafo)) {
+          return DrawLineKernel (*this, theXTrafo, static_cast<const LinTrafo &>(*mYTrafo), theXSpan, theYSpan.mData, theStart, theEnd, inRect, theMarkerRect, inPainter);
+        }
+        if (typeid (*mYTrafo) == typeid (LogTrafo)) {
+          return DrawLineKernel (*this, theXTrafo, static_cast<const LogTrafo &>(*mYTrafo), theXSpan, theYSpan.mData, theStart, theEnd, inRect, theMarkerRect, inPainter);
+        }
+      }
 
       for (int theI = theStart; theI <= theEnd; theI+=theStride) {
 
-        theTraX = mXTrafo->Transform (inXData.GetValue (theI));
+        theTraX = mXTrafo->Transform (theXSpan[theI]);
         if (theStride > 1) {
           long theLast = theI + theStride - 1;
           if (theLast>theEnd) {
             theLast = theEnd;
           }
-            theTraY = mYTrafo->Transform (GetMaxFromRange (inYData, theI, theLast));
+            theTraY = mYTrafo->Transform (GetMaxFromRange (theYSpan, theI, theLast));
         }
         else {
-            theTraY = mYTrafo->Transform (inYData.GetValue (theI));
+            theTraY = mYTrafo->Transform (theYSpan[theI]);
         }
 
-        if (!theFirst && mDrawLine) {
-          inPainter.DrawLine (thePrevX, thePrevY, theTraX, theTraY);
+        if (theSimplify) {
+          if (theSimplifier.AddPoint (theTraX, theTraY, theI, theVertexX, theVertexY, theVertexIndex)) {
+            theEmitVertex (theVertexX, theVertexY);
+          }
         }
-        else {
-          theFirst = false;
+        else if (mDrawLine) {
+          theEmitVertex (theTraX, theTraY);
         }
-        bool theDrawPoint = mDrawPoint;
+        bool theMarkerVisible = theTraX >= theMarkerRect.mX && theTraX <= theMarkerRect.mX+theMarkerRect.mW &&
+                                theTraY >= theMarkerRect.mY && theTraY <= theMarkerRect.mY+theMarkerRect.mH;
+        bool theDrawPoint = mDrawPoint && theMarkerVisible;
 
         if (theDrawPoint && !DrawPoint (theTraX, theTraY, inRect, inPainter)) {
           return false;
         }
-        if (inPlotDataSelection.IsSelected (theI) && !DrawSelection (theTraX, theTraY, inRect, inPainter)) {
+        if (theMarkerVisible && inPlotDataSelection.IsSelected (theI) && !DrawSelection (theTraX, theTraY, inRect, inPainter)) {
           return false;
         }
-        thePrevX = theTraX;
-        thePrevY = theTraY;
+      }
+      if (theSimplify && theSimplifier.Finish (theVertexX, theVertexY, theVertexIndex)) {
+        theEmitVertex (theVertexX, theVertexY);
       }
       return true;
     }
@@ -1521,16 +3218,25 @@ namespace SVGChart {
         return new LineDataDrawer (*this);
     }
 
+    bool LineDataDrawer::AddToHash (ContentHasher &ioHasher) const {
+      AddBaseToHash (ioHasher);
+      ioHasher.AddLong (mDrawLine);
+      ioHasher.AddLong (mDrawPoint);
+      ioHasher.AddFloat (mSimplifyTolerance);
+      ioHasher.AddStyle (mStyle);
+      return true;
+    }
+
     bool LineDataDrawer::DrawPoint (int inScreenX, int inScreenY, [[maybe_unused]] const PRect &inRect, Painter &inPainter) const {
-      inPainter.DrawLine (inScreenX-5, inScreenY+5, inScreenX+5, inScreenY-5);
-      inPainter.DrawLine (inScreenX-5, inScreenY-5, inScreenX+5, inScreenY+5);
+      inPainter.DrawLine (inScreenX-kMarkerSize, inScreenY+kMarkerSize, inScreenX+kMarkerSize, inScreenY-kMarkerSize);
+      inPainter.DrawLine (inScreenX-kMarkerSize, inScreenY-kMarkerSize, inScreenX+kMarkerSize, inScreenY+kMarkerSize);
       return true;
     }
 
     bool LineDataDrawer::DrawSelection (int inScreenX, int inScreenY, [[maybe_unused]] const PRect &inRect, Painter &inPainter) const {
     //  inPainter.DrawLine (inScreenX-5, inScreenY+5, inScreenX+5, inScreenY-5);
     //  inPainter.DrawLine (inScreenX-5, inScreenY-5, inScreenX+5, inScreenY+5);
-      inPainter.FillRect (inScreenX-5, inScreenY-5, 10, 10);
+      inPainter.FillRect (inScreenX-kMarkerSize, inScreenY-kMarkerSize, 2*kMarkerSize, 2*kMarkerSize);
       return true;
     }
 
@@ -1539,6 +3245,30 @@ namespace SVGChart {
       return true;
     }
 
+    static const long kTransformBlockSize = 256;
+
+    // Transforms inCount values of inSpan from inStart. The common trafos are
+    // called non-virtually, so the loop over a block can be inlined.
+    static void TransformBlock (const Trafo &inTrafo, const PlotDataSpan &inSpan, long inStart, long inCount, float *outValues) {
+      if (typeid (inTrafo) == typeid (LinTrafo)) {
+        const LinTrafo &theTrafo = static_cast<const LinTrafo &>(inTrafo);
+        for (long theI=0;theI<inCount;theI++) {
+          outValues[theI] = theTrafo.LinTrafo::Transform (inSpan[inStart+theI]);
+        }
+      }
+      else if (typeid (inTrafo) == typeid (LogTrafo)) {
+        const LogTrafo &theTrafo = static_cast<const LogTrafo &>(inTrafo);
+        for (long theI=0;theI<inCount;theI++) {
+          outValues[theI] = theTrafo.LogTrafo::Transform (inSpan[inStart+theI]);
+        }
+      }
+      else {
+        for (long theI=0;theI<inCount;theI++) {
+          outValues[theI] = inTrafo.Transform (inSpan[inStart+theI]);
+        }
+      }
+    }
+
     bool BarDataDrawer::DrawData (const PlotDataBase &inXData, const PlotDataBase &inYData, const PlotDataSelection &inPlotDataSelection, const AxisSetup &inXAxisSetup, const PRect &inRect, Painter &inPainter) const {
       if (!mXTrafo || !mYTrafo) {
         return false;
@@ -1553,23 +3283,71 @@ namespace SVGChart {
         return DrawOnlyLastPoint (inXData, inYData, inPlotDataSelection, inXAxisSetup, inRect, inPainter);
       }
 
-      int theTraX, theTraY;
       int theTraY0 = mYTrafo->Transform (0);
 
-      int theLeft, theTop, theWidth, theHeight;
-
-      theWidth = inRect.mW/inXData.GetSize ();
-      
-      for (long theI=0;theI<inXData.GetSize ();theI++) {
-        theTraX = mXTrafo->Transform (inXData.GetValue (theI));
-        theTraY = mYTrafo->Transform (inYData.GetValue (theI));
-
-        theLeft = theTraX-theWidth/2;
-        theTop = theTraY;
-        theHeight = theTraY0-theTop;
+      PlotDataSpan theXSpan = inXData.GetSpan ();
+      PlotDataSpan theYSpan = inYData.GetSpan ();
+      long theSize = theXSpan.GetSize ();
+      if (theSize == 0) {
+        return true;
+      }
 
-        inPainter.FillRect (theLeft, theTop, theWidth, theHeight);
+      // with more bars than pixels, the bars of each pixel column merge
+      // into one rect spanning all of them
+      int theWidth = inRect.mW/theSize;
+      bool theCoalesce = theWidth == 0;
+      if (theCoalesce) {
+        theWidth = 1;
+      }
+
+      vector<PRect> theRects;
+      theRects.reserve (theCoalesce ? inRect.mW+1 : theSize);
+      auto theAddRect = [&] (long inX, long inY, long inW, long inH) {
+        PRect theRect;
+        theRect.mX = inX;
+        theRect.mY = inY;
+        theRect.mW = inW;
+        theRect.mH = inH;
+        theRects.push_back (theRect);
+      };
+      bool theColumnOpen = false;
+      int theColumn = 0, theColumnTop = 0, theColumnBottom = 0;
+
+      float theTraXs[kTransformBlockSize];
+      float theTraYs[kTransformBlockSize];
+      for (long theStart=0;theStart<theSize;theStart+=kTransformBlockSize) {
+        long theCount = PMin (theSize-theStart, (long)kTransformBlockSize);
+        TransformBlock (*mXTrafo, theXSpan, theStart, theCount, theTraXs);
+        TransformBlock (*mYTrafo, theYSpan, theStart, theCount, theTraYs);
+        for (long theI=0;theI<theCount;theI++) {
+          int theTraX = theTraXs[theI];
+          int theTraY = theTraYs[theI];
+          int theLeft = theTraX-theWidth/2;
+          if (!theCoalesce) {
+            theAddRect (theLeft, theTraY, theWidth, theTraY0-theTraY);
+            continue;
+          }
+          int theTop = PMin (theTraY, theTraY0);
+          int theBottom = PMax (theTraY, theTraY0);
+          if (theColumnOpen && theLeft == theColumn) {
+            theColumnTop = PMin (theColumnTop, theTop);
+            theColumnBottom = PMax (theColumnBottom, theBottom);
+            continue;
+          }
+          if (theColumnOpen) {
+            theAddRect (theColumn, theColumnTop, 1, theColumnBottom-theColumnTop);
+          }
+          theColumnOpen = true;
+          theColumn = theLeft;
+          theColumnTop = theTop;
+          theColumnBottom = theBottom;
+        }
       }
+      if (theColumnOpen) {
+        theAddRect (theColumn, theColumnTop, 1, theColumnBottom-theColumnTop);
+      }
+
+      inPainter.FillRects (theRects.data (), theRects.size ());
       return true;
     }
 
@@ -1607,6 +3385,150 @@ namespace SVGChart {
         return new BarDataDrawer (*this);
     }
 
+    bool BarDataDrawer::AddToHash (ContentHasher &ioHasher) const {
+      AddBaseToHash (ioHasher);
+      ioHasher.AddLong (mDrawOnlyLastPoint);
+      return true;
+    }
+
+    const long kMinPointsPerBinThread = 1<<16;
+
+    void DensityDataDrawer::BinPoints (const PlotDataSpan &inXData, const PlotDataSpan &inYData, long inBegin, long inEnd, const PRect &inRect, vector<unsigned int> &ioCounts) const {
+      for (long theI=inBegin;theI<inEnd;theI++) {
+        float theX = mXTrafo->Transform (inXData[theI]) - inRect.mX;
+        float theY = mYTrafo->Transform (inYData[theI]) - inRect.mY;
+        // the negated test also rejects NaN
+        if (!(theX >= 0 && theX < inRect.mW && theY >= 0 && theY < inRect.mH)) {
+          continue;
+        }
+        ioCounts[long (theY)*inRect.mW + long (theX)]++;
+      }
+    }
+
+    PColor DensityDataDrawer::GetLevelColor (float inLevel) const {
+      PColor theC;
+      theC.mR = mLowColor.mR + PPlot::Round ((mHighColor.mR - mLowColor.mR)*inLevel);
+      theC.mG = mLowColor.mG + PPlot::Round ((mHighColor.mG - mLowColor.mG)*inLevel);
+      theC.mB = mLowColor.mB + PPlot::Round ((mHighColor.mB - mLowColor.mB)*inLevel);
+      return theC;
+    }
+
+    bool DensityDataDrawer::DrawData (const PlotDataBase &inXData, const PlotDataBase &inYData, [[maybe_unused]] const PlotDataSelection &inPlotDataSelection, [[maybe_unused]] const AxisSetup &inXAxisSetup, const PRect &inRect, Painter &inPainter) const {
+      if (!mXTrafo || !mYTrafo) {
+        return false;
+      }
+      long theSize = inXData.GetSize ();
+      if (theSize>inYData.GetSize ()) {
+        return false;
+      }
+      if (inRect.mW <= 0 || inRect.mH <= 0) {
+        return true;
+      }
+
+      // 2D histogram, row major so each thread streams through its own grid
+      PlotDataSpan theXSpan = inXData.GetSpan ();
+      PlotDataSpan theYSpan = inYData.GetSpan ();
+      long theCells = inRect.mW*inRect.mH;
+      vector<unsigned int> theCounts (theCells, 0);
+      long theThreadCount = PMin<long> (mThreadCount, theSize/kMinPointsPerBinThread);
+      if (theThreadCount > 1) {
+        vector<vector<unsigned int> > thePartials (theThreadCount-1, vector<unsigned int> (theCells, 0));
+        vector<thread> theThreads;
+        long theChunk = theSize/theThreadCount;
+        for (long theT=1;theT<theThreadCount;theT++) {
+          long theBegin = theT*theChunk;
+          long theEnd = theT == theThreadCount-1 ? theSize : theBegin+theChunk;
+          theThreads.push_back (thread ([&, theT, theBegin, theEnd] () {
+            BinPoints (theXSpan, theYSpan, theBegin, theEnd, inRect, thePartials[theT-1]);
+          }));
+        }
+        BinPoints (theXSpan, theYSpan, 0, theChunk, inRect, theCounts);
+        for (long theT=0;theT<(long)theThreads.size ();theT++) {
+          theThreads[theT].join ();
+          const vector<unsigned int> &thePartial = thePartials[theT];
+          for (long theC=0;theC<theCells;theC++) {
+            theCounts[theC] += thePartial[theC];
+          }
+        }
+      }
+      else {
+        BinPoints (theXSpan, theYSpan, 0, theSize, inRect, theCounts);
+      }
+
+      unsigned int theMaxCount = *max_element (theCounts.begin (), theCounts.end ());
+      if (theMaxCount == 0) {
+        return true;
+      }
+      float theNorm = mLogScale ? log1p ((float)theMaxCount) : theMaxCount;
+      int theLevels = PMax (mLevels, 2);
+      auto NormalizeCount = [&] (unsigned int inCount) {
+        return (mLogScale ? log1p ((float)inCount) : inCount)/theNorm;
+      };
+      auto QuantizeLevel = [&] (unsigned int inCount) {
+        return PMin (theLevels-1, (int)(NormalizeCount (inCount)*(theLevels-1)+0.5f));
+      };
+
+      if (mUseImage) {
+        vector<unsigned char> theImage (theCells*4, 0);
+        for (long theC=0;theC<theCells;theC++) {
+          unsigned int theCount = theCounts[theC];
+          if (theCount == 0) {
+            continue;// transparent
+          }
+          PColor theColor = GetLevelColor (NormalizeCount (theCount));
+          theImage[theC*4] = theColor.mR;
+          theImage[theC*4+1] = theColor.mG;
+          theImage[theC*4+2] = theColor.mB;
+          theImage[theC*4+3] = 255;
+        }
+        if (inPainter.DrawImage (inRect.mX, inRect.mY, inRect.mW, inRect.mH, theImage.data ())) {
+          return true;
+        }
+      }
+
+      // fall back to one FillRect per run of equal color level in a row
+      int theCurrentLevel = -1;
+      for (long theRow=0;theRow<inRect.mH;theRow++) {
+        const unsigned int *theRowCounts = &theCounts[theRow*inRect.mW];
+        long theCol = 0;
+        while (theCol < inRect.mW) {
+          if (theRowCounts[theCol] == 0) {
+            theCol++;
+            continue;
+          }
+          int theLevel = QuantizeLevel (theRowCounts[theCol]);
+          long theRunStart = theCol;
+          for (theCol++;theCol<inRect.mW && theRowCounts[theCol] != 0;theCol++) {
+            if (QuantizeLevel (theRowCounts[theCol]) != theLevel) {
+              break;
+            }
+          }
+          if (theLevel != theCurrentLevel) {
+            PColor theColor = GetLevelColor ((float)theLevel/(theLevels-1));
+            inPainter.SetFillColor (theColor.mR, theColor.mG, theColor.mB);
+            theCurrentLevel = theLevel;
+          }
+          inPainter.FillRect (inRect.mX+theRunStart, inRect.mY+theRow, theCol-theRunStart, 1);
+        }
+      }
+      return true;
+    }
+
+    DataDrawerBase* DensityDataDrawer::Clone () const {
+        return new DensityDataDrawer (*this);
+    }
+
+    bool DensityDataDrawer::AddToHash (ContentHasher &ioHasher) const {
+      // mThreadCount only changes how the counts are computed
+      AddBaseToHash (ioHasher);
+      ioHasher.AddLong (mLogScale);
+      ioHasher.AddLong (mUseImage);
+      ioHasher.AddLong (mLevels);
+      AddColorToHash (mLowColor, ioHasher);
+      AddColorToHash (mHighColor, ioHasher);
+      return true;
+    }
+
     bool PPlot::DrawPlot (int inIndex, const PRect &inRect, Painter &inPainter) const {
 
       if (inIndex>=mPlotDataContainer.GetPlotCount ()) {
@@ -1648,6 +3570,11 @@ namespace SVGChart {
         mXTrafo = &mXLogTrafo;
         mYAxisSetup.mCrossOrigin = false;
       }
+      else if (mXAxisSetup.mTimeScale) {
+        mXTickIterator = &mXTimeTickIterator;
+        mXTrafo = &mXLinTrafo;
+        mYAxisSetup.mCrossOrigin = false;// time 0 is arbitrary
+      }
       else {
         const PlotDataBase *theGlue = mPlotDataContainer.GetConstXData (0);
         const StringData *theStringXData = dynamic_cast<const StringData *>(theGlue);
@@ -1665,6 +3592,11 @@ namespace SVGChart {
         mYTrafo = &mYLogTrafo;
         mXAxisSetup.mCrossOrigin = false;
       }
+      else if (mYAxisSetup.mTimeScale) {
+        mYTickIterator = &mYTimeTickIterator;
+        mYTrafo = &mYLinTrafo;
+        mXAxisSetup.mCrossOrigin = false;
+      }
       else {
         mYTickIterator = &mYLinTickIterator;
         mYTrafo = &mYLinTrafo;
@@ -1710,7 +3642,15 @@ namespace SVGChart {
       float theXMin;
       float theXMax;
 
-      mPlotDataContainer.CalculateXRange (theXMin, theXMax);
+      bool theHasXRange = mXAxisGroup && mXAxisGroup->GetRange (theXMin, theXMax);
+      if (!theHasXRange && mSharedXRange.mSet) {
+        theXMin = mSharedXRange.mMin;
+        theXMax = mSharedXRange.mMax;
+        theHasXRange = true;
+      }
+      if (!theHasXRange) {
+        mPlotDataContainer.CalculateXRange (theXMin, theXMax);
+      }
       if (mXAxisSetup.mAutoScaleMin || mXAxisSetup.mAutoScaleMax) {
 
         if (mXAxisSetup.mAutoScaleMin) {
@@ -1733,8 +3673,14 @@ namespace SVGChart {
         float theYMin;
         float theYMax;
 
-        mPlotDataContainer.CalculateYRange (mXAxisSetup.mMin, mXAxisSetup.mMax,
-                        theYMin, theYMax);
+        if (mSharedYRange.mSet) {
+          theYMin = mSharedYRange.mMin;
+          theYMax = mSharedYRange.mMax;
+        }
+        else {
+          mPlotDataContainer.CalculateYRange (mXAxisSetup.mMin, mXAxisSetup.mMax,
+                          theYMin, theYMax);
+        }
 
         if (mYAxisSetup.mAutoScaleMin) {
           mYAxisSetup.mMin = theYMin;
@@ -1790,6 +3736,16 @@ namespace SVGChart {
         if (!mXTickIterator->InitFromRanges (theXRange, inRect.mH, theDivGuess, mXAxisSetup.mTickInfo)) {
           return false;
         }
+        if (mXTickIterator == &mXNamedTickIterator && !mXNamedTickIterator.FitLabels (theXRange, inRect.mW, inPainter, mXAxisSetup.mTickInfo)) {
+          return false;
+        }
+        if (mXTickIterator == &mXTimeTickIterator) {
+          // dates are wider than the numbers the guess assumes
+          int theLabelWidth = inPainter.CalculateTextDrawSize (mXTimeTickIterator.GetSampleLabel (mXAxisSetup.mTickInfo));
+          if (theLabelWidth > theTextWidth && !mXTickIterator->InitFromRanges (theXRange, inRect.mH, theDivGuess*theTextWidth/theLabelWidth, mXAxisSetup.mTickInfo)) {
+            return false;
+          }
+        }
       }
       if (mYAxisSetup.mTickInfo.mAutoTick) {
         float theTextHeight = inPainter.GetFontHeight ();
@@ -1919,6 +3875,22 @@ namespace SVGChart {
         MakeExamplePlot8 (ioPPlot);
         return true;
         break;
+      case 9:
+        MakeExamplePlot9 (ioPPlot);
+        return true;
+        break;
+      case 10:
+        MakeExamplePlot10 (ioPPlot);
+        return true;
+        break;
+      case 11:
+        MakeExamplePlot11 (ioPPlot);
+        return true;
+        break;
+      case 12:
+        MakeExamplePlot12 (ioPPlot);
+        return true;
+        break;
       }
       return false;
     }
@@ -2146,6 +4118,112 @@ namespace SVGChart {
       ioPPlot.mMargins.mTop = 50;
 
     }
+
+    void MakeExamplePlot9 (PPlot &ioPPlot) {
+
+      ioPPlot.mPlotBackground.mTitle = "point density";
+      PlotData *theX1 = new PlotData ();
+      PlotData *theY1 = new PlotData ();
+      // two clusters; a sum of uniform numbers from a fixed LCG keeps the
+      // points the same on every platform
+      unsigned int theSeed = 12345;
+      for (int theI=0;theI<20000;theI++) {
+        float theSum[2] = {0, 0};
+        for (int theK=0;theK<8;theK++) {
+          theSeed = theSeed*1103515245u+12345u;
+          theSum[theK%2] += (theSeed>>8)/(float)(1<<24);
+        }
+        bool theFirst = theI%3 != 0;
+        theX1->push_back ((theFirst ? 3 : 6)+(theSum[0]-2)*(theFirst ? 1.5f : 1.0f));
+        theY1->push_back ((theFirst ? 4 : 7)+(theSum[1]-2)*(theFirst ? 1.0f : 2.0f));
+      }
+      LegendData *theLegend = new LegendData ();
+      theLegend->mName = "samples";
+      theLegend->mColor = PColor (189,0,38);
+      ioPPlot.mPlotDataContainer.AddXYPlot (theX1, theY1, theLegend, new DensityDataDrawer ());
+      ioPPlot.mMargins.mLeft = 50;
+      ioPPlot.mMargins.mTop = 50;
+      ioPPlot.mXAxisSetup.mCrossOrigin = false;
+      ioPPlot.mYAxisSetup.mCrossOrigin = false;
+    }
+
+    void MakeExamplePlot10 (PPlot &ioPPlot) {
+
+      ioPPlot.mPlotBackground.mTitle = "time axes";
+      // x: hours over new year 1970, so the 12 hour ticks need dates; y:
+      // milliseconds, ticked below a second
+      PlotData *theX1 = new PlotData ();
+      PlotData *theY1 = new PlotData ();
+      for (int theI=0;theI<=36;theI++) {
+        theX1->push_back (theI);
+        theY1->push_back (120+90*sin (theI*0.3));
+      }
+      LegendData *theLegend = new LegendData ();
+      theLegend->mName = "latency";
+      theLegend->mColor = PColor (100,100,200);
+      ioPPlot.mPlotDataContainer.AddXYPlot (theX1, theY1, theLegend);
+      ioPPlot.mXAxisSetup.mTimeScale = true;
+      ioPPlot.mXAxisSetup.mTimeOrigin = DaysFromCivil (1969, 12, 31)*(double)kSecondsPerDay;
+      ioPPlot.mXAxisSetup.mTimeUnit = 3600;
+      ioPPlot.mXAxisSetup.mTickInfo.mAutoTick = false;
+      ioPPlot.mXAxisSetup.mTickInfo.mMajorTickSpan = 12;
+      ioPPlot.mXAxisSetup.mTickInfo.mTickDivision = 4;
+      ioPPlot.mXAxisSetup.mTickInfo.mLabelAngle = -45;
+      ioPPlot.mYAxisSetup.mTimeScale = true;
+      ioPPlot.mYAxisSetup.mTimeOrigin = DaysFromCivil (2024, 5, 17)*(double)kSecondsPerDay+12*3600;
+      ioPPlot.mYAxisSetup.mTimeUnit = 0.001;
+      ioPPlot.mMargins.mLeft = 90;
+      ioPPlot.mMargins.mTop = 50;
+      ioPPlot.mMargins.mBottom = 90;
+    }
+
+    void MakeExamplePlot11 (PPlot &ioPPlot) {
+
+      ioPPlot.mPlotBackground.mTitle = "many series";
+      // more names than the legend can hold: it wraps into a second column
+      // and ends in "+N more"
+      const char *theSites[] = {"north", "south", "east", "west", "central"};
+      for (int theI=0;theI<40;theI++) {
+        PlotData *theX1 = new PlotData ();
+        PlotData *theY1 = new PlotData ();
+        for (int theK=0;theK<=20;theK++) {
+          theX1->push_back (theK);
+          theY1->push_back (theI+2*sin (theK*0.3+theI));
+        }
+        LegendData *theLegend = new LegendData ();
+        char theName[64];
+        snprintf (theName, sizeof (theName), "%s %02d", theSites[theI%5], theI+1);
+        theLegend->mName = theName;
+        theLegend->mColor = PColor (50+(theI*37)%180, 50+(theI*71)%180, 50+(theI*113)%180);
+        ioPPlot.mPlotDataContainer.AddXYPlot (theX1, theY1, theLegend);
+      }
+      ioPPlot.mLegendSetup.mDrawSwatches = true;
+      ioPPlot.mMargins.mLeft = 50;
+      ioPPlot.mMargins.mTop = 50;
+    }
+
+    void MakeExamplePlot12 (PPlot &ioPPlot) {
+
+      ioPPlot.mPlotBackground.mTitle = "many categories";
+      // far more category names than fit below the axis, so only every Nth
+      // is labeled
+      StringData *theX1 = new StringData ();
+      PlotData *theY1 = new PlotData ();
+      for (int theI=0;theI<5000;theI++) {
+        char theName[16];
+        snprintf (theName, sizeof (theName), "item %04d", theI+1);
+        theX1->AddItem (theName);
+        theY1->push_back (5+4*sin (theI*0.01)+(theI*7919)%5);
+      }
+      LegendData *theLegend = new LegendData ();
+      theLegend->mName = "count";
+      theLegend->mColor = PColor (100,100,200);
+      ioPPlot.mPlotDataContainer.AddXYPlot (theX1, theY1, theLegend, new BarDataDrawer ());
+      ioPPlot.mXAxisSetup.mTickInfo.mLabelAngle = -45;
+      ioPPlot.mMargins.mLeft = 50;
+      ioPPlot.mMargins.mTop = 30;
+      ioPPlot.mMargins.mBottom = 80;
+    }
     
     void MakePainterTester (PPlot &ioPPlot) {
       ioPPlot.SetPPlotDrawer (new PainterTester ());
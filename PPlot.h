@@ -44,6 +44,9 @@ using std::vector;
 using std::string;
 #include <map>
 using std::map;
+#include <cstdint>
+#include <mutex>
+using std::mutex;
 
 namespace SVGChart {
 
@@ -63,6 +66,32 @@ namespace SVGChart {
         virtual long GetSize () const = 0;
     };
 
+    // Plot data resolved for iteration: contiguous floats, the affine sequence
+    // mOffset+i*mDelta, or (for other calculated data) a virtual call per
+    // value. Fetch it once with PlotDataBase::GetSpan, it stays valid until
+    // the data changes.
+    class PlotDataSpan {
+     public:
+      PlotDataSpan () = default;
+
+      float operator[] (long inIndex) const {
+        if (mData) {
+          return mData[inIndex];
+        }
+        if (mCalculated) {
+          return mCalculated->GetValue (inIndex);
+        }
+        return mOffset + inIndex * mDelta;
+      }
+      long GetSize () const {return mSize;}
+
+      const float *mData{ nullptr };
+      long mSize{ 0 };
+      float mOffset{ 0 };
+      float mDelta{ 0 };
+      const CalculatedDataBase *mCalculated{ nullptr };
+    };
+
     // data
     class PlotDataBase {
      public:
@@ -70,7 +99,8 @@ namespace SVGChart {
       virtual const RealPlotData * GetRealPlotData () const = 0;
       virtual const CalculatedDataBase * GetCalculatedData () const {return nullptr;}
       long GetSize () const;
-      float GetValue (long inIndex) const;
+      float GetValue (long inIndex) const;// per element, prefer GetSpan in loops
+      PlotDataSpan GetSpan () const;
 
       virtual bool CalculateRange (float &outMin, float &outMax);
     };
@@ -162,6 +192,10 @@ namespace SVGChart {
       long mH{0};
     };
 
+    // Liang-Barsky clipping of a segment to a rectangle (edges included).
+    // Returns false if nothing of the segment is inside.
+    bool ClipLine (float &ioX1, float &ioY1, float &ioX2, float &ioY2, const PRect &inRect);
+
     class PMargins {
      public:
       PMargins () = default;
@@ -219,6 +253,9 @@ namespace SVGChart {
 
       virtual void DrawLine (float inX1, float inY1, float inX2, float inY2)=0;
       virtual void FillRect (int inX, int inY, int inW, int inH)=0;
+      // many rects in the current fill color, e.g. the bars of a plot; painters
+      // that can emit them as one shape override it
+      virtual void FillRects (const PRect *inRects, long inCount);
       virtual void InvertRect (int inX, int inY, int inW, int inH)=0;
       virtual void SetClipRect (int inX, int inY, int inW, int inH)=0;
       virtual long GetWidth () const=0;
@@ -231,6 +268,143 @@ namespace SVGChart {
       virtual void DrawRotatedText (int inX, int inY, float inDegrees, const char *inString)=0;
       virtual void SetStyle ([[maybe_unused]] const PStyle &inStyle)
         {}
+      // inW x inH pixels, 8 bit RGBA, row major. Returns false if images are not supported.
+      virtual bool DrawImage ([[maybe_unused]] int inX, [[maybe_unused]] int inY, [[maybe_unused]] int inW, [[maybe_unused]] int inH, [[maybe_unused]] const unsigned char *inRGBA)
+        {return false;}
+      // whether DrawImage draws, for painters that record calls for another one
+      virtual bool CanDrawImage () const
+        {return false;}
+      // bytes of output produced so far, 0 if the painter doesn't know
+      virtual long GetOutputSize ()
+        {return 0;}
+    };
+
+    // Produces no output. Text is measured with fixed per character metrics,
+    // primitives are only counted and their bounding box kept, so layout and
+    // data drawing can be timed without the cost of an output format.
+    class DummyPainter: public Painter {
+     public:
+      DummyPainter (long inWidth=400, long inHeight=300)
+          : mWidth (inWidth), mHeight (inHeight)
+        {}
+
+      virtual void DrawLine (float inX1, float inY1, float inX2, float inY2);
+      virtual void FillRect (int inX, int inY, int inW, int inH);
+      virtual void InvertRect (int inX, int inY, int inW, int inH);
+      virtual void SetClipRect ([[maybe_unused]] int inX, [[maybe_unused]] int inY, [[maybe_unused]] int inW, [[maybe_unused]] int inH)
+        {}
+      virtual long GetWidth () const {return mWidth;}
+      virtual long GetHeight () const {return mHeight;}
+      virtual void SetLineColor ([[maybe_unused]] int inR, [[maybe_unused]] int inG, [[maybe_unused]] int inB)
+        {}
+      virtual void SetFillColor ([[maybe_unused]] int inR, [[maybe_unused]] int inG, [[maybe_unused]] int inB)
+        {}
+      virtual long CalculateTextDrawSize (const char *inString);
+      virtual long GetFontHeight () const {return mFontHeight;}
+      virtual void DrawText (int inX, int inY, const char *inString);
+      virtual void DrawRotatedText (int inX, int inY, float inDegrees, const char *inString);
+      virtual bool DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA);
+      virtual bool CanDrawImage () const {return true;}
+
+      void Reset ();// counts and bounds
+      long GetPrimitiveCount () const
+        {return mLineCount+mRectCount+mTextCount+mImageCount;}
+      bool GetBounds (PRect &outRect) const;// of everything drawn, false if nothing was
+
+      long mWidth;
+      long mHeight;
+      long mCharWidth{ 8 };// per UTF-8 character
+      long mFontHeight{ 16 };
+
+      long mLineCount{ 0 };
+      long mRectCount{ 0 };// FillRect and InvertRect
+      long mTextCount{ 0 };
+      long mImageCount{ 0 };
+     protected:
+      void AddBounds (float inX1, float inY1, float inX2, float inY2);
+
+      bool mHasBounds{ false };
+      float mMinX{ 0 };
+      float mMinY{ 0 };
+      float mMaxX{ 0 };
+      float mMaxY{ 0 };
+    };
+
+    // Forwards to another painter and counts the primitives: lines, rects
+    // (each of a FillRects batch), texts and the images it drew. RenderProfile
+    // and ProfilingPainter count with it.
+    class CountingPainter: public Painter {
+     public:
+      CountingPainter (Painter &inPainter)
+          : mPainter (inPainter)
+        {}
+
+      virtual void DrawLine (float inX1, float inY1, float inX2, float inY2)
+        {mPrimitiveCount++; mPainter.DrawLine (inX1, inY1, inX2, inY2);}
+      virtual void FillRect (int inX, int inY, int inW, int inH)
+        {mPrimitiveCount++; mPainter.FillRect (inX, inY, inW, inH);}
+      virtual void FillRects (const PRect *inRects, long inCount)
+        {mPrimitiveCount += inCount; mPainter.FillRects (inRects, inCount);}
+      virtual void InvertRect (int inX, int inY, int inW, int inH)
+        {mPrimitiveCount++; mPainter.InvertRect (inX, inY, inW, inH);}
+      virtual void SetClipRect (int inX, int inY, int inW, int inH)
+        {mPainter.SetClipRect (inX, inY, inW, inH);}
+      virtual long GetWidth () const
+        {return mPainter.GetWidth ();}
+      virtual long GetHeight () const
+        {return mPainter.GetHeight ();}
+      virtual void SetLineColor (int inR, int inG, int inB)
+        {mPainter.SetLineColor (inR, inG, inB);}
+      virtual void SetFillColor (int inR, int inG, int inB)
+        {mPainter.SetFillColor (inR, inG, inB);}
+      virtual long CalculateTextDrawSize (const char *inString)
+        {return mPainter.CalculateTextDrawSize (inString);}
+      virtual long GetFontHeight () const
+        {return mPainter.GetFontHeight ();}
+      virtual void DrawText (int inX, int inY, const char *inString)
+        {mPrimitiveCount++; mPainter.DrawText (inX, inY, inString);}
+      virtual void DrawRotatedText (int inX, int inY, float inDegrees, const char *inString)
+        {mPrimitiveCount++; mPainter.DrawRotatedText (inX, inY, inDegrees, inString);}
+      virtual void SetStyle (const PStyle &inStyle)
+        {mPainter.SetStyle (inStyle);}
+      virtual bool DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA) {
+        bool theDrawn = mPainter.DrawImage (inX, inY, inW, inH, inRGBA);
+        mPrimitiveCount += theDrawn;
+        return theDrawn;
+      }
+      virtual bool CanDrawImage () const
+        {return mPainter.CanDrawImage ();}
+      virtual long GetOutputSize ()
+        {return mPainter.GetOutputSize ();}
+
+      long mPrimitiveCount{ 0 };
+     protected:
+      Painter &mPainter;
+    };
+
+    // where ElideText puts the "..."
+    enum ElideMode { kElideStart, kElideMiddle, kElideEnd };
+
+    // Returns inText if it measures less than inMaxWidth, otherwise the longest
+    // elided version that does (just "..." if nothing else fits). The cut point
+    // is found by binary search, so only O(log n) strings get measured.
+    string ElideText (const string &inText, long inMaxWidth, ElideMode inMode, Painter &inPainter);
+
+    // Incremental 64 bit hash for PPlot::GetContentHash, 8 bytes per step.
+    // Fast and well mixed, but not cryptographic.
+    class ContentHasher {
+     public:
+      void AddBytes (const void *inData, size_t inSize);
+      void AddLong (long inValue) {AddBytes (&inValue, sizeof (inValue));}
+      void AddFloat (float inValue) {AddBytes (&inValue, sizeof (inValue));}
+      void AddDouble (double inValue) {AddBytes (&inValue, sizeof (inValue));}
+      void AddString (const string &inString);// length prefixed, so "ab","c" differs from "a","bc"
+      void AddStyle (const PStyle &inStyle);
+      uint64_t GetHash () const;
+
+     protected:
+      uint64_t mState{ 0x243F6A8885A308D3ULL };
+      uint64_t mLength{ 0 };
     };
 
     class Trafo;
@@ -250,7 +424,14 @@ namespace SVGChart {
       virtual bool DrawData (const PlotDataBase &inXData, const PlotDataBase &inYData, const PlotDataSelection &inPlotDataSelection, const AxisSetup &inXAxisSetup, const PRect &inRect, Painter &inPainter) const =0;
 
       virtual DataDrawerBase* Clone () const = 0;
+      // Adds every setting that affects the output. Returns false if the
+      // drawer can't tell, which makes the plot uncacheable; subclasses with
+      // settings of their own must override it.
+      virtual bool AddToHash ([[maybe_unused]] ContentHasher &ioHasher) const
+        {return false;}
      protected:
+      void AddBaseToHash (ContentHasher &ioHasher) const;// type and fast mode
+
       Trafo *mXTrafo{nullptr};
       Trafo *mYTrafo{nullptr};
       bool  mDrawFast{false};
@@ -260,6 +441,37 @@ namespace SVGChart {
 
     typedef vector<DataDrawerBase *> DataDrawerList;
 
+    // Streaming polyline simplification in screen space, linear in the
+    // number of points. Points within half the tolerance of the last kept
+    // vertex are dropped, and runs that keep moving forward inside a corridor
+    // of half the tolerance around the run's direction collapse to their end
+    // points, so no dropped point is further than mTolerance from the output.
+    class PolylineSimplifier {
+    public:
+      PolylineSimplifier (float inTolerance)
+          : mTolerance (inTolerance)
+        {}
+
+      // returns true if a vertex became final; it is one of the input points
+      bool AddPoint (float inX, float inY, long inIndex, float &outX, float &outY, long &outIndex);
+      // emits the last pending point, if any
+      bool Finish (float &outX, float &outY, long &outIndex);
+
+      float mTolerance;// pixels
+    protected:
+      bool mHasAnchor{ false };
+      bool mHasPending{ false };
+      bool mHasDirection{ false };
+      float mAnchorX{ 0 };
+      float mAnchorY{ 0 };
+      float mPendingX{ 0 };
+      float mPendingY{ 0 };
+      long mPendingIndex{ 0 };
+      float mDirX{ 0 };
+      float mDirY{ 0 };
+      float mMaxProjection{ 0 };
+    };
+
     class LineDataDrawer: public DataDrawerBase {
      public:
       LineDataDrawer () = default;
@@ -271,11 +483,15 @@ namespace SVGChart {
       virtual bool DrawData (const PlotDataBase &inXData, const PlotDataBase &inYData, const PlotDataSelection &inPlotDataSelection, const AxisSetup &inXAxisSetup, const PRect &inRect, Painter &inPainter) const;
 
       virtual DataDrawerBase* Clone () const;
+      virtual bool AddToHash (ContentHasher &ioHasher) const;
       virtual bool DrawPoint (int inScreenX, int inScreenY, const PRect &inRect, Painter &inPainter) const;
       virtual bool DrawSelection (int inScreenX, int inScreenY, const PRect &inRect, Painter &inPainter) const;
 
+      static const int kMarkerSize = 5;// half size of point and selection markers, for culling
+
       bool mDrawLine{ true };
       bool mDrawPoint{ false };
+      float mSimplifyTolerance{ 0 };// pixels; > 0 simplifies the line with PolylineSimplifier
       PStyle mStyle;
     };
 
@@ -295,6 +511,7 @@ namespace SVGChart {
 
       virtual bool DrawData (const PlotDataBase &inXData, const PlotDataBase &inYData, const PlotDataSelection &inPlotDataSelection, const AxisSetup &inXAxisSetup, const PRect &inRect, Painter &inPainter) const;
       virtual DataDrawerBase* Clone () const;
+      virtual bool AddToHash (ContentHasher &ioHasher) const;
 
      protected:
       bool mDrawOnlyLastPoint{ false }; // special mode
@@ -302,6 +519,29 @@ namespace SVGChart {
     };
 
 
+    // Bins the points into a per-pixel count grid over the plot rectangle and
+    // draws it through a colormap, so the output size is bounded by the plot
+    // rectangle instead of the number of points.
+    class DensityDataDrawer: public DataDrawerBase {
+     public:
+      DensityDataDrawer () = default;
+
+      virtual bool DrawData (const PlotDataBase &inXData, const PlotDataBase &inYData, const PlotDataSelection &inPlotDataSelection, const AxisSetup &inXAxisSetup, const PRect &inRect, Painter &inPainter) const;
+      virtual DataDrawerBase* Clone () const;
+      virtual bool AddToHash (ContentHasher &ioHasher) const;
+
+      bool mLogScale{ true };// log colormap, otherwise linear in the count
+      bool mUseImage{ true };// embed a raster image if the painter supports it, otherwise FillRect spans
+      int mLevels{ 16 };// color levels used for FillRect spans
+      int mThreadCount{ 1 };// bin large series in parallel
+      PColor mLowColor{ 255, 237, 160 };
+      PColor mHighColor{ 189, 0, 38 };
+
+     protected:
+      void BinPoints (const PlotDataSpan &inXData, const PlotDataSpan &inYData, long inBegin, long inEnd, const PRect &inRect, vector<unsigned int> &ioCounts) const;
+      PColor GetLevelColor (float inLevel) const;
+    };
+
     class PlotDataContainer {
      public:
       PlotDataContainer ();
@@ -335,8 +575,11 @@ namespace SVGChart {
       bool CalculateYRange (float inXMin, float inXMax, float &outYMin, float &outYMax) const;
       bool CalculateYRangePlot (float inXMin, float inXMax, const PlotDataBase &inXData, const PlotDataBase &inYData, float &outYMin, float &outYMax) const;
 
+      long GetGeneration () const {return mGeneration;}// changes whenever plots are added, replaced or removed
+
      protected:
       bool CheckState () const;
+      long mGeneration{ 0 };
       PlotDataList mXDataList;
       PlotDataList mYDataList;
       LegendDataList mLegendDataList;
@@ -344,6 +587,37 @@ namespace SVGChart {
       PlotDataSelectionList mPlotDataSelectionList;
     };
 
+    // Uniform grid over the screen coordinates of one plot's points, so a
+    // screen position can be mapped back to data points without a full scan.
+    // Only points inside the plot rectangle (the visible ones) are indexed.
+    class PlotSpatialIndex {
+    public:
+      PlotSpatialIndex () = default;
+
+      void Build (const PlotDataBase &inXData, const PlotDataBase &inYData, const Trafo &inXTrafo, const Trafo &inYTrafo, const PRect &inRect);
+      void Clear ();
+      bool IsBuilt () const {return mBuilt;}
+
+      // returns the point index, negative if no point is within inMaxDistance
+      long FindNearest (float inScreenX, float inScreenY, float inMaxDistance, float &outDistance) const;
+      void FindInRect (const PRect &inScreenRect, vector<long> &outIndices) const;
+
+      int mCellSize{ 0 };// pixels, 0: chosen from the point density
+    protected:
+      void GetCell (float inScreenX, float inScreenY, long &outCol, long &outRow) const;
+      void VisitCell (long inCol, long inRow, float inScreenX, float inScreenY, long &ioBest, float &ioBestDist2) const;
+
+      bool mBuilt{ false };
+      int mUsedCellSize{ 1 };
+      PRect mRect;
+      long mCols{ 0 };
+      long mRows{ 0 };
+      vector<float> mScreenX;// indexed by point
+      vector<float> mScreenY;
+      vector<long> mCellStart;// mCols*mRows+1 offsets into mCellPoints
+      vector<long> mCellPoints;// point indices, grouped by cell
+    };
+
     class GridInfo {
     public:
         GridInfo () = default;
@@ -361,6 +635,10 @@ namespace SVGChart {
       static float RoundSpan (float inSpan);
 
       static void MakeFormatString (float inValue, string &outFormatString);
+      static const char * GetFormatString (float inValue);// same as above, without allocating
+      // printf style formatting of a tick value into outBuf, returns the length.
+      // "%.Nf" and "%.Ne" take a fast path that gives the same text.
+      static int FormatLabel (float inValue, const char *inFormatString, char *outBuf, int inBufSize);
 
       bool mAutoTick{ true };
       bool mAutoTickSize{ true };
@@ -371,6 +649,7 @@ namespace SVGChart {
       int mMajorTickScreenSize{ 1 };
       int mMinorTickScreenSize{ 1 };
       string mFormatString{ "%.0f" };
+      float mLabelAngle{ 0 };// [degrees] of the x tick labels, e.g. -90 or -45 for crowded categories; leave room in mMargins.mBottom
       PStyle mStyle;
     };
 
@@ -395,7 +674,18 @@ namespace SVGChart {
       long mLogFactor{ 1 };// to make db possible with logscale
       float mLogBase{ 10 };
 
+      // time axis: value v is mTimeOrigin+v*mTimeUnit seconds since 1970-01-01 UTC.
+      // Keep the origin near the data, floats can't hold epoch times.
+      bool mTimeScale{ false };
+      double mTimeOrigin{ 0 };// [seconds since epoch]
+      double mTimeUnit{ 1 };// [seconds per plot unit]
+
+      float TimeValue (double inSeconds) const
+        {return (inSeconds-mTimeOrigin)/mTimeUnit;}
+      float TimeValue (int64_t inSeconds, long inNanoseconds) const;// exact for large timestamps
+
       string mLabel;
+      ElideMode mLabelElide{ kElideEnd };// when the label is longer than the axis
       PStyle mStyle;
 
       TickInfo mTickInfo;
@@ -430,6 +720,31 @@ namespace SVGChart {
       float mFactor{ 1 };
     };
 
+    // The ticks of one axis, computed once per Draw and shared by grid and
+    // axis drawing. Labels are stored zero terminated in one char arena.
+    class TickList {
+     public:
+      struct Tick {
+        float mValue;
+        bool mIsMajor;
+        long mLabelOffset;// into mLabels
+      };
+
+      void Clear ()
+        {mTicks.clear (); mLabels.clear ();}
+      void AddTick (float inValue, bool inIsMajor, const char *inLabel, int inLength);
+      long GetCount () const
+        {return mTicks.size ();}
+      const Tick & GetTick (long inIndex) const
+        {return mTicks[inIndex];}
+      const char * GetLabel (long inIndex) const
+        {return &mLabels[mTicks[inIndex].mLabelOffset];}
+
+     protected:
+      vector<Tick> mTicks;
+      vector<char> mLabels;
+    };
+
     class TickIterator {
     public:
       TickIterator () = default;
@@ -437,6 +752,8 @@ namespace SVGChart {
 
       virtual bool Init ()=0;
       virtual bool GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString)=0;
+      // Init and collect all ticks, with formatted labels for the major ones
+      virtual bool FillTicks (TickList &outTickList);
 
       virtual bool InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &outTickInfo) const=0;
       virtual bool AdjustRange ([[maybe_unused]] float &ioMin, [[maybe_unused]] float &ioMax) const
@@ -453,12 +770,16 @@ namespace SVGChart {
       LinTickIterator () = default;
       virtual bool Init ();
       virtual bool GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString);
+      virtual bool FillTicks (TickList &outTickList);
 
       bool InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &outTickInfo) const;
     protected:
-      float mCurrentTick{ 0 };
-      long mCount{ 0 }; //was uninitialized
-      float mDelta{ 0 };
+      bool Step (float &outTick, bool &outIsMajorTick);
+
+      // tick k is at k*mDelta, so nothing accumulates
+      long mCount{ 0 };
+      long mLastCount{ -1 };
+      double mDelta{ 0 };
       string mFormatString;
     };
 
@@ -467,30 +788,85 @@ namespace SVGChart {
       LogTickIterator () = default;
       virtual bool Init ();
       virtual bool GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString);
+      virtual bool FillTicks (TickList &outTickList);
 
       bool InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &outTickInfo) const;
       virtual bool AdjustRange (float &ioMin, float &ioMax) const;
       float RoundUp (float inFloat) const;
       float RoundDown (float inFloat) const;
     protected:
-      float mCurrentTick{ 0 };
-      long mCount{ 0 }; //was uninitialized
-      float mDelta{ 0 };
+      bool Step (float &outTick, bool &outIsMajorTick, int &outPow);
+
+      // the current tick is (1+mMinor*mDelta)*base^mPow
+      int mPow{ 0 };
+      long mMinor{ 0 };
+      long mMinorPerDecade{ 1 };
+      double mDelta{ 0 };// relative to the decade
     };
 
     class NamedTickIterator: public LinTickIterator {
     public:
       NamedTickIterator () = default;
 
+      // not copied, the list has to outlive the iterator's use of it
       void SetStringList (const vector<string> &inStringList)
-        {mStringList = inStringList;}
+        {mStringList = &inStringList;}
 
       //  virtual bool Init ();
       virtual bool GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString);
+      virtual bool FillTicks (TickList &outTickList);
+
+      bool InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &outTickInfo) const;
+      // Labels every 1, 2, 5, 10, ... categories so that the widest visible
+      // label (or its height, if rotated) fits between neighbours.
+      bool FitLabels (float inParRange, float inScreenRange, Painter &inPainter, TickInfo &ioTickInfo) const;
+    protected:
+      const vector<string> *mStringList{ nullptr };
+    };
+
+    // Ticks on an AxisSetup::mTimeScale axis, at steps from nanoseconds up to
+    // years. Months and years follow the calendar, weeks start on Monday.
+    // Labels read like 12:30, 2024-05-17 or 2024-05 depending on the step.
+    // Steps below a day on an axis over more than one day also show the date
+    // on the first label and on the first one of each new day.
+    class TimeTickIterator: public TickIterator {
+    public:
+      TimeTickIterator () = default;
+      virtual bool Init ();
+      virtual bool GetNextTick (float &outTick, bool &outIsMajorTick, string &outFormatString);
+      virtual bool FillTicks (TickList &outTickList);
 
       bool InitFromRanges (float inParRange, float inOrthoScreenRange, float inDivGuess, TickInfo &outTickInfo) const;
+
+      struct Step {
+        double mSeconds;// major step, nominal for months
+        long mMonths;// > 0: calendar step of this many months
+        int mDivision;// minor steps per major step
+      };
+      static Step ChooseStep (double inSeconds);// the smallest step not below inSeconds
+      // a label as wide as the ones for this tick info, for measuring
+      const char * GetSampleLabel (const TickInfo &inTickInfo) const;
     protected:
-      vector<string> mStringList;
+      bool NextTick (float &outTick, bool &outIsMajorTick, long &outDay, double &outSecondOfDay);
+      int FormatLabel (long inDay, double inSecondOfDay, char *outBuf);
+      bool SpansDays () const;// the axis range covers more than one calendar day
+
+      Step mStep{ 1, 0, 1 };
+      double mMinorSeconds{ 1 };
+      long mMinorMonths{ 0 };
+      // times are kept relative to mBaseDay, so sub-second steps stay exact
+      long mBaseDay{ 0 };// [days since epoch]
+      double mOriginOffset{ 0 };// mTimeOrigin-mBaseDay*86400
+      int64_t mBaseIndex{ 0 };// minor steps from the major step alignment to mBaseDay
+      int64_t mIndex{ 0 };
+      int64_t mLastIndex{ -1 };
+      // calendar breakdown of the last labeled day
+      long mLabelDay{ 0 };
+      int mLabelYear{ 0 };
+      int mLabelMonth{ 0 };
+      int mLabelDayOfMonth{ 0 };
+      bool mHasLabelDay{ false };
+      bool mDated{ false };// times below a day get the date on day changes
     };
 
     class PlotBackground {
@@ -499,9 +875,24 @@ namespace SVGChart {
       bool mTransparent{ true };
       PColor mPlotRegionBackColor{ 255, 255, 255 };
       string mTitle;
+      ElideMode mTitleElide{ kElideEnd };
       PStyle mStyle;
     };
 
+    // Entries are stacked top to bottom and wrap into further columns to
+    // the right; what does not fit is summarized by a "+N more" entry.
+    class LegendSetup {
+     public:
+      LegendSetup () = default;
+      bool mUsePlotRect{ true };// place the legend in the plot region
+      PRect mBox;// painter coordinates, used if !mUsePlotRect
+      int mXOffset{ 20 };// [pixels] from the left of the box to the text
+      int mColumnGap{ 10 };// [pixels]
+      int mMaxColumns{ 0 };// 0: as many as fit
+      bool mDrawSwatches{ false };// colored square left of the name
+      ElideMode mElide{ kElideStart };// for names wider than the box
+    };
+
     class PPlot;
 
     class PDrawer {
@@ -532,6 +923,100 @@ namespace SVGChart {
         virtual bool Draw (Painter &inPainter);
     };
 
+    // How often each Draw stage ran, to check that unchanged layout is reused
+    struct PPlotStageCounts {
+      long mConfigure{ 0 };// ConfigureSelf
+      long mRanges{ 0 };// CalculateAxisRanges, scans all data
+      long mTicks{ 0 };// CalculateTickInfo
+      long mTickLists{ 0 };// tick values and labels
+      long mTransforms{ 0 };// screen transformations
+      long mEmit{ 0 };// drawing into the painter
+    };
+
+    // Wall time and counters of PPlot::Draw, per stage. Set PPlot::mProfile
+    // to collect them; successive Draw calls add up until Clear.
+    class RenderProfile {
+     public:
+      enum Stage {
+        kConfigure,
+        kRanges,
+        kTicks,// tick info and tick lists
+        kTransforms,
+        kCalculators,// modifying and post calculators
+        kPreDrawers,
+        kBackground,
+        kGrid,
+        kAxes,
+        kLegend,
+        kPlots,// all DrawPlot calls, see also mPlotSeconds
+        kPostDrawers,
+        kStageCount
+      };
+
+      RenderProfile () {Clear ();}
+
+      void Clear ();
+      static const char * GetStageName (int inStage);
+      string toJSON () const;
+
+      long mDrawCount;
+      double mTotalSeconds;
+      double mStageSeconds[kStageCount];
+      long mStageCalls[kStageCount];
+      vector<double> mPlotSeconds;// per plot index
+      long mPointsVisited;// points of the plots handed to the data drawers
+      long mPrimitives;// lines, rects, texts and images sent to the painter
+      long mBytes;// painter output, see Painter::GetOutputSize
+    };
+
+    // PPlots that share their x axis, e.g. stacked panels over one time
+    // span. The union x range is computed once for all members and the x
+    // ticks once per axis setup and length, then reused by every member
+    // until one of them changes its data. Members must autoscale x to get
+    // the common range. The group does not own its members.
+    class AxisGroup {
+     public:
+      AxisGroup () = default;
+      ~AxisGroup ();
+
+      void AddPlot (PPlot *inPPlot);// sets inPPlot->mXAxisGroup
+      void RemovePlot (PPlot *inPPlot);
+      long GetPlotCount () const {return mPlotList.size ();}
+
+      // Members may be drawn on different threads (e.g. by a PlotGrid), the
+      // shared state is locked; adding and removing members is not.
+      void SetDataChanged ();// for values changed in place
+      long GetVersion ();// changes whenever the members' data does
+      bool GetRange (float &outMin, float &outMax);// union of the members' x data
+      // false if no member has filled ticks for this axis setup and length yet
+      bool GetTicks (const AxisSetup &inAxisSetup, long inLength, TickList &outTickList);
+      void StoreTicks (const AxisSetup &inAxisSetup, long inLength, const TickList &inTickList);
+
+      long GetRangeScans () const {return mRangeScans;}// number of union computations, to check the reuse
+      long GetTickFills () const {return mTickFills;}
+
+     protected:
+      AxisGroup (const AxisGroup&);
+      AxisGroup& operator=(const AxisGroup&);
+
+      long UpdateVersion ();// with mLock held
+
+      mutex mLock;
+      vector<PPlot *> mPlotList;
+      vector<long> mDataState;// generation and x sizes of each member, when last checked
+      bool mDataChanged{ false };
+      long mVersion{ 0 };
+      bool mHasRange{ false };
+      float mMin{ 0 };
+      float mMax{ 0 };
+      bool mHasTicks{ false };
+      AxisSetup mTickAxisSetup;
+      long mTickLength{ 0 };
+      TickList mTickList;
+      long mRangeScans{ 0 };
+      long mTickFills{ 0 };
+    };
+
     class PPlot: public PDrawer {
      public:
       PPlot ();
@@ -545,6 +1030,7 @@ namespace SVGChart {
       GridInfo  mGridInfo;
       PMargins mMargins;// [pixels]
       PlotBackground mPlotBackground;
+      LegendSetup mLegendSetup;
 
       void SetPPlotDrawer (PDrawer *inPDrawer);// taker ownership. Used to bypass normal Draw function, i.e., set Draw function by composition.
       void SetPPlotDrawer (PDrawer &inPDrawer);// same as above: does not take ownership
@@ -571,6 +1057,59 @@ namespace SVGChart {
 
       static int Round (float inFloat);
       static const float kRangeVerySmall;
+
+      // hit testing in screen coordinates of the last Draw; the per plot
+      // spatial index is built on the first query after each Draw.
+      bool FindNearestPoint (float inScreenX, float inScreenY, float inMaxDistance, int &outPlotIndex, long &outPointIndex) const;
+      bool FindPointsInRect (int inPlotIndex, const PRect &inScreenRect, vector<long> &outPointIndices) const;
+      bool SelectPointsInRect (int inPlotIndex, const PRect &inScreenRect);// marks them in the plot's PlotDataSelection
+      const PRect & GetPlotRect () const {return mPlotRect;}// the region hit tests cover
+
+      // With mReuseLayout set, the layout (ranges, ticks and transformations)
+      // is kept between Draw calls and redone only when the data, axis setups,
+      // margins or the painter's size or font changed. Plot data edited in
+      // place can't be seen, call SetDataChanged afterwards. Off by default:
+      // every Draw does the full layout.
+      bool mReuseLayout{ false };
+      void SetDataChanged () {
+        mLayout.mDataGeneration = -1;
+        mDataChangeCount++;
+        if (mXAxisGroup) {
+          mXAxisGroup->SetDataChanged ();
+        }
+      }
+      // SetDataChanged calls so far (each Draw without mReuseLayout makes
+      // one), for callers that cache results derived from the data
+      long GetDataChangeCount () const {return mDataChangeCount;}
+      const PPlotStageCounts & GetStageCounts () const {return mStageCounts;}
+
+      RenderProfile *mProfile{ nullptr };// not owned; null: no profiling
+      AxisGroup *mXAxisGroup{ nullptr };// set by AxisGroup::AddPlot
+
+      // A data range an autoscaled axis uses instead of the plot's own; it is
+      // still clipped for log scale and rounded by the tick iterator. PlotGrid
+      // sets them for shared axes.
+      struct SharedRange {
+        bool mSet{ false };
+        float mMin{ 0 };
+        float mMax{ 0 };
+      };
+      SharedRange mSharedXRange;
+      SharedRange mSharedYRange;
+
+      enum {
+        kDataDirty = 1,
+        kAxisDirty = 2,
+        kMarginsDirty = 4,
+        kPainterDirty = 8
+      };
+      int GetDirtyFlags (Painter &inPainter) const;// of the layout, for the next Draw
+      // Hash of everything that affects the output apart from the painter:
+      // data values, axes, styles, margins, legend, background and drawer
+      // settings. Same before and after a Draw. Returns false for plots that
+      // can't be hashed: custom PPlot drawer, pre or post drawers, calculators,
+      // a data drawer without AddToHash or membership in an AxisGroup.
+      bool GetContentHash (uint64_t &outHash) const;
      protected:
       PPlot (const PPlot&);
       PPlot& operator=(const PPlot&);
@@ -579,8 +1118,8 @@ namespace SVGChart {
       static bool CalculateLinTransformation (int inBegin, int inEnd, const AxisSetup& inAxisSetup, LinTrafo& outTrafo);
 
       virtual bool DrawPlotBackground (const PRect &inRect, Painter &inPainter) const;
-      virtual bool DrawXTick (float inX, int inScreenY, bool inMajor, const string &inFormatString, Painter &inPainter, PRect &outRect) const;
-      virtual bool DrawYTick (float inY, int inScreenX, bool inMajor, const string &inFormatString, Painter &inPainter, PRect &outRect) const;
+      virtual bool DrawXTick (float inX, int inScreenY, bool inMajor, const char *inLabel, Painter &inPainter, PRect &outRect) const;
+      virtual bool DrawYTick (float inY, int inScreenX, bool inMajor, const char *inLabel, Painter &inPainter, PRect &outRect) const;
       virtual bool DrawLegend (const PRect &inRect, Painter &inPainter) const;
       virtual bool DrawPlot (int inIndex, const PRect &inRect, Painter &inPainter) const;
       virtual bool ConfigureSelf ();// change here implementations of interfaces
@@ -601,9 +1140,47 @@ namespace SVGChart {
       LogTickIterator mXLogTickIterator;
       LogTickIterator mYLogTickIterator;
       NamedTickIterator mXNamedTickIterator;
+      TimeTickIterator mXTimeTickIterator;
+      TimeTickIterator mYTimeTickIterator;
+
+      // filled once per Draw, after the tick info and ranges are final
+      TickList mXTickList;
+      TickList mYTickList;
 
       PDrawer * mPPlotDrawer{ nullptr };
       bool mOwnsPPlotDrawer{ true };
+      long mDataChangeCount{ 0 };
+
+      const PlotSpatialIndex * GetSpatialIndex (int inPlotIndex) const;
+      PRect mPlotRect;// plot region of the last Draw
+      mutable vector<PlotSpatialIndex> mSpatialIndexList;
+
+      // inputs and results of the last layout
+      struct LayoutState {
+        bool mValid{ false };
+        long mDataGeneration{ 0 };
+        vector<long> mDataSizes;// x and y size of each plot
+        PMargins mMargins;
+        long mPainterWidth{ 0 };
+        long mPainterHeight{ 0 };
+        long mFontHeight{ 0 };
+        long mTextWidth{ 0 };
+        long mXAxisGroupVersion{ 0 };
+        SharedRange mSharedXRange;
+        SharedRange mSharedYRange;
+        AxisSetup mXInput;// as configured, before the ranges
+        AxisSetup mYInput;
+        AxisSetup mXOutput;// after the layout
+        AxisSetup mYOutput;
+        long mRangeCount{ 0 };// number of entries in mRanges
+        float mRanges[2][4];// x min, x max, y min, y max after each range pass
+      };
+      bool DrawStages (Painter &inPainter);
+      bool CalculateLayout (const PRect &inRect, Painter &inPainter, bool inReuseRanges);
+      void StoreLayoutInputs (Painter &inPainter);
+
+      LayoutState mLayout;
+      PPlotStageCounts mStageCounts;
     };
 
     bool MakeExamplePlot (int inExample, PPlot &ioPPlot);
@@ -615,6 +1192,10 @@ namespace SVGChart {
     void MakeExamplePlot6 (PPlot &ioPPlot);
     void MakeExamplePlot7 (PPlot &ioPPlot);
     void MakeExamplePlot8 (PPlot &ioPPlot);
+    void MakeExamplePlot9 (PPlot &ioPPlot);
+    void MakeExamplePlot10 (PPlot &ioPPlot);
+    void MakeExamplePlot11 (PPlot &ioPPlot);
+    void MakeExamplePlot12 (PPlot &ioPPlot);
     void MakePainterTester (PPlot &ioPPlot);
 
     void MakeCopy (const PPlot &inPPlot, PPlot &outPPlot);
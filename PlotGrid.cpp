@@ -0,0 +1,341 @@
+//
+//  PlotGrid.cpp
+//
+//  Lays out many PPlots as panels of one painter, for small
+//  multiples and dashboards.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "PlotGrid.h"
+#include "DisplayListPainter.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace SVGChart {
+    using namespace std;
+
+    namespace {
+        // Answers the layout queries of one panel while it records into a
+        // display list on a worker thread. Text goes to the real painter under
+        // a lock, with the style this panel last set, since it may pick the font.
+        class MeasurePainter: public Painter {
+        public:
+            MeasurePainter(Painter &painter, mutex &lock, long width, long height)
+                : painter(painter), lock(lock), width(width), height(height) {}
+
+            virtual void DrawLine ([[maybe_unused]] float inX1, [[maybe_unused]] float inY1, [[maybe_unused]] float inX2, [[maybe_unused]] float inY2) {}
+            virtual void FillRect ([[maybe_unused]] int inX, [[maybe_unused]] int inY, [[maybe_unused]] int inW, [[maybe_unused]] int inH) {}
+            virtual void InvertRect ([[maybe_unused]] int inX, [[maybe_unused]] int inY, [[maybe_unused]] int inW, [[maybe_unused]] int inH) {}
+            virtual void SetClipRect ([[maybe_unused]] int inX, [[maybe_unused]] int inY, [[maybe_unused]] int inW, [[maybe_unused]] int inH) {}
+            virtual long GetWidth () const { return width; }
+            virtual long GetHeight () const { return height; }
+            virtual void SetLineColor ([[maybe_unused]] int inR, [[maybe_unused]] int inG, [[maybe_unused]] int inB) {}
+            virtual void SetFillColor ([[maybe_unused]] int inR, [[maybe_unused]] int inG, [[maybe_unused]] int inB) {}
+            virtual long CalculateTextDrawSize (const char *inString) {
+                lock_guard<mutex> guard(lock);
+                applyStyle();
+                return painter.CalculateTextDrawSize(inString);
+            }
+            virtual long GetFontHeight () const {
+                lock_guard<mutex> guard(lock);
+                applyStyle();
+                return painter.GetFontHeight();
+            }
+            virtual void DrawText ([[maybe_unused]] int inX, [[maybe_unused]] int inY, [[maybe_unused]] const char *inString) {}
+            virtual void DrawRotatedText ([[maybe_unused]] int inX, [[maybe_unused]] int inY, [[maybe_unused]] float inDegrees, [[maybe_unused]] const char *inString) {}
+            virtual void SetStyle (const PStyle &inStyle) {
+                style = inStyle;
+                hasStyle = true;
+            }
+            virtual bool CanDrawImage () const {
+                lock_guard<mutex> guard(lock);
+                return painter.CanDrawImage();
+            }
+
+        private:
+            void applyStyle() const {
+                if (hasStyle) {
+                    painter.SetStyle(style);
+                }
+            }
+
+            Painter &painter;
+            mutex &lock;
+            long width;
+            long height;
+            PStyle style;
+            bool hasStyle = false;
+        };
+    }
+
+    void PanelPainter::DrawLine (float inX1, float inY1, float inX2, float inY2) {
+        painter.DrawLine(inX1 + rect.mX, inY1 + rect.mY, inX2 + rect.mX, inY2 + rect.mY);
+    }
+
+    void PanelPainter::FillRect (int inX, int inY, int inW, int inH) {
+        painter.FillRect(inX + rect.mX, inY + rect.mY, inW, inH);
+    }
+
+    void PanelPainter::FillRects (const PRect *inRects, long inCount) {
+        vector<PRect> shifted(inRects, inRects + inCount);
+        for (PRect &shiftedRect : shifted) {
+            shiftedRect.mX += rect.mX;
+            shiftedRect.mY += rect.mY;
+        }
+        painter.FillRects(shifted.data(), inCount);
+    }
+
+    void PanelPainter::InvertRect (int inX, int inY, int inW, int inH) {
+        painter.InvertRect(inX + rect.mX, inY + rect.mY, inW, inH);
+    }
+
+    void PanelPainter::SetClipRect (int inX, int inY, int inW, int inH) {
+        painter.SetClipRect(inX + rect.mX, inY + rect.mY, inW, inH);
+    }
+
+    void PanelPainter::DrawText (int inX, int inY, const char *inString) {
+        painter.DrawText(inX + rect.mX, inY + rect.mY, inString);
+    }
+
+    void PanelPainter::DrawRotatedText (int inX, int inY, float inDegrees, const char *inString) {
+        painter.DrawRotatedText(inX + rect.mX, inY + rect.mY, inDegrees, inString);
+    }
+
+    bool PanelPainter::DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA) {
+        return painter.DrawImage(inX + rect.mX, inY + rect.mY, inW, inH, inRGBA);
+    }
+
+    void PlotGrid::setPlot(int row, int column, PPlot *plot) {
+        if (row >= 0 && row < rows && column >= 0 && column < columns) {
+            plots[row * columns + column] = plot;
+        }
+    }
+
+    PPlot *PlotGrid::getPlot(int row, int column) const {
+        if (row >= 0 && row < rows && column >= 0 && column < columns) {
+            return plots[row * columns + column];
+        }
+        return nullptr;
+    }
+
+    PRect PlotGrid::getCellRect(int row, int column, const Painter &painter) const {
+        // the remainder pixels go to the first cells, so the grid fills the painter
+        long width = painter.GetWidth() - (columns - 1) * spacing;
+        long height = painter.GetHeight() - (rows - 1) * spacing;
+        PRect rect;
+        rect.mX = column * (width / columns) + min<long>(column, width % columns) + column * spacing;
+        rect.mY = row * (height / rows) + min<long>(row, height % rows) + row * spacing;
+        rect.mW = width / columns + (column < width % columns ? 1 : 0);
+        rect.mH = height / rows + (row < height % rows ? 1 : 0);
+        return rect;
+    }
+
+    void PlotGrid::forEachPanel(size_t count, const function<void(size_t)> &body) const {
+        atomic<size_t> next(0);
+        auto work = [&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                body(i);
+            }
+        };
+        int workers = (int)min<size_t>(max(threadCount, 1), count);
+        vector<thread> threads;
+        for (int i = 1; i < workers; i++) {
+            threads.push_back(thread(work));
+        }
+        work();
+        for (thread &worker : threads) {
+            worker.join();
+        }
+    }
+
+    void PlotGrid::shareRanges() {
+        size_t count = plots.size();
+        vector<char> used(count, 0);
+        for (size_t i = 0; i < count; i++) {
+            used[i] = plots[i] && plots[i]->mPlotDataContainer.GetPlotCount() > 0;
+        }
+        // forget the ranges of panels whose data changed since the last draw
+        panelRanges.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            if (!used[i]) {
+                continue;
+            }
+            const PlotDataContainer &container = plots[i]->mPlotDataContainer;
+            vector<long> sizes;
+            for (int plot = 0; plot < container.GetPlotCount(); plot++) {
+                sizes.push_back(container.GetConstXData(plot)->GetSize());
+                sizes.push_back(container.GetConstYData(plot)->GetSize());
+            }
+            PanelRanges &cached = panelRanges[i];
+            if (cached.plot != plots[i] || cached.generation != container.GetGeneration() ||
+                cached.dataChanges != plots[i]->GetDataChangeCount() || cached.sizes != sizes) {
+                cached = PanelRanges();
+                cached.plot = plots[i];
+                cached.generation = container.GetGeneration();
+                cached.dataChanges = plots[i]->GetDataChangeCount();
+                cached.sizes = sizes;
+            }
+        }
+        atomic<long> scans(0);
+        // per panel ranges, fixed ends as they are and autoscaled ones from
+        // the data; the y range depends on the (shared) x range
+        vector<float> minX(count), maxX(count), minY(count), maxY(count);
+        forEachPanel(count, [&](size_t i) {
+            if (!used[i]) {
+                return;
+            }
+            const AxisSetup &axis = plots[i]->mXAxisSetup;
+            PanelRanges &cached = panelRanges[i];
+            if ((axis.mAutoScaleMin || axis.mAutoScaleMax) && !cached.hasX) {
+                plots[i]->mPlotDataContainer.CalculateXRange(cached.minX, cached.maxX);
+                cached.hasX = true;
+                scans++;
+            }
+            minX[i] = axis.mAutoScaleMin ? cached.minX : axis.mMin;
+            maxX[i] = axis.mAutoScaleMax ? cached.maxX : axis.mMax;
+        });
+        // min and max over the used panels of a row or column, false if there are none
+        auto combine = [&](const vector<float> &mins, const vector<float> &maxs, size_t first, size_t step, size_t cells,
+                           float &outMin, float &outMax) {
+            bool found = false;
+            for (size_t cell = 0, i = first; cell < cells; cell++, i += step) {
+                if (used[i]) {
+                    outMin = found ? min(outMin, mins[i]) : mins[i];
+                    outMax = found ? max(outMax, maxs[i]) : maxs[i];
+                    found = true;
+                }
+            }
+            return found;
+        };
+        // the panels autoscale to the union, so each still clips it for log
+        // scale and rounds it to its ticks; fixed ends stay as they are
+        auto share = [&](PPlot::SharedRange PPlot::*range, float inMin, float inMax, size_t first, size_t step, size_t cells) {
+            for (size_t cell = 0, i = first; cell < cells; cell++, i += step) {
+                if (used[i]) {
+                    PPlot::SharedRange &shared = plots[i]->*range;
+                    shared.mSet = true;
+                    shared.mMin = inMin;
+                    shared.mMax = inMax;
+                }
+            }
+        };
+        if (shareX) {
+            for (int column = 0; column < columns; column++) {
+                float sharedMin = 0, sharedMax = 0;
+                if (combine(minX, maxX, column, columns, rows, sharedMin, sharedMax)) {
+                    share(&PPlot::mSharedXRange, sharedMin, sharedMax, column, columns, rows);
+                }
+            }
+        }
+        if (shareY) {
+            forEachPanel(count, [&](size_t i) {
+                if (!used[i]) {
+                    return;
+                }
+                const AxisSetup &xAxis = plots[i]->mXAxisSetup;
+                const AxisSetup &axis = plots[i]->mYAxisSetup;
+                const PPlot::SharedRange &sharedX = plots[i]->mSharedXRange;
+                float xMin = sharedX.mSet && xAxis.mAutoScaleMin ? sharedX.mMin : minX[i];
+                float xMax = sharedX.mSet && xAxis.mAutoScaleMax ? sharedX.mMax : maxX[i];
+                PanelRanges &cached = panelRanges[i];
+                if ((axis.mAutoScaleMin || axis.mAutoScaleMax) &&
+                    !(cached.hasY && cached.yFromX == xMin && cached.yToX == xMax)) {
+                    plots[i]->mPlotDataContainer.CalculateYRange(xMin, xMax, cached.minY, cached.maxY);
+                    cached.hasY = true;
+                    cached.yFromX = xMin;
+                    cached.yToX = xMax;
+                    scans++;
+                }
+                minY[i] = axis.mAutoScaleMin ? cached.minY : axis.mMin;
+                maxY[i] = axis.mAutoScaleMax ? cached.maxY : axis.mMax;
+            });
+            for (int row = 0; row < rows; row++) {
+                float sharedMin = 0, sharedMax = 0;
+                if (combine(minY, maxY, row * columns, 1, columns, sharedMin, sharedMax)) {
+                    share(&PPlot::mSharedYRange, sharedMin, sharedMax, row * columns, 1, columns);
+                }
+            }
+        }
+        rangeScans += scans;
+    }
+
+    bool PlotGrid::draw(Painter &painter) {
+        if (shareX || shareY) {
+            shareRanges();
+        }
+        bool ok = true;
+        if (threadCount > 1) {
+            ok = drawParallel(painter);
+        } else {
+            for (int row = 0; row < rows; row++) {
+                for (int column = 0; column < columns; column++) {
+                    PPlot *plot = getPlot(row, column);
+                    if (plot) {
+                        PanelPainter panel(painter, getCellRect(row, column, painter));
+                        ok = plot->Draw(panel) && ok;
+                    }
+                }
+            }
+        }
+        if (shareX || shareY) {
+            for (PPlot *plot : plots) {
+                if (plot) {
+                    plot->mSharedXRange = PPlot::SharedRange();
+                    plot->mSharedYRange = PPlot::SharedRange();
+                }
+            }
+        }
+        return ok;
+    }
+
+    bool PlotGrid::drawParallel(Painter &painter) {
+        size_t count = plots.size();
+        vector<unique_ptr<MeasurePainter>> measures(count);
+        vector<unique_ptr<DisplayListPainter>> lists(count);
+        vector<char> drawn(count, 1);
+        mutex lock;
+        for (size_t i = 0; i < count; i++) {
+            if (plots[i]) {
+                PRect rect = getCellRect(i / columns, i % columns, painter);
+                measures[i].reset(new MeasurePainter(painter, lock, rect.mW, rect.mH));
+                lists[i].reset(new DisplayListPainter(*measures[i]));
+            }
+        }
+
+        forEachPanel(count, [&](size_t i) {
+            if (plots[i]) {
+                drawn[i] = plots[i]->Draw(*lists[i]);
+            }
+        });
+
+        bool ok = true;
+        for (size_t i = 0; i < count; i++) {
+            if (plots[i]) {
+                PanelPainter panel(painter, getCellRect(i / columns, i % columns, painter));
+                lists[i]->replay(panel);
+                ok = ok && drawn[i];
+            }
+        }
+        return ok;
+    }
+}
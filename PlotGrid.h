@@ -0,0 +1,142 @@
+//
+//  PlotGrid.h
+//
+//  Lays out many PPlots as panels of one painter, for small
+//  multiples and dashboards.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef PlotGrid_h
+#define PlotGrid_h
+
+#include <functional>
+#include <vector>
+#include "PPlot.h"
+
+namespace SVGChart {
+    using namespace std;
+
+    // Draws into a rectangle of another painter: coordinates are shifted by
+    // the rectangle's origin and it reports the rectangle's size, so a PPlot
+    // drawn into it lays itself out for the panel.
+    class PanelPainter: public Painter {
+    public:
+        // painter must outlive this object
+        PanelPainter(Painter &painter, const PRect &rect): painter(painter), rect(rect) {}
+        // Overidden member functions
+        virtual void DrawLine (float inX1, float inY1, float inX2, float inY2);
+        virtual void FillRect (int inX, int inY, int inW, int inH);
+        virtual void FillRects (const PRect *inRects, long inCount);
+        virtual void InvertRect (int inX, int inY, int inW, int inH);
+        virtual void SetClipRect (int inX, int inY, int inW, int inH);
+        virtual long GetWidth () const { return rect.mW; }
+        virtual long GetHeight () const { return rect.mH; }
+        virtual void SetLineColor (int inR, int inG, int inB) { painter.SetLineColor(inR, inG, inB); }
+        virtual void SetFillColor (int inR, int inG, int inB) { painter.SetFillColor(inR, inG, inB); }
+        virtual long CalculateTextDrawSize (const char *inString) { return painter.CalculateTextDrawSize(inString); }
+        virtual long GetFontHeight () const { return painter.GetFontHeight(); }
+        virtual void DrawText (int inX, int inY, const char *inString);
+        virtual void DrawRotatedText (int inX, int inY, float inDegrees, const char *inString);
+        virtual void SetStyle (const PStyle &inStyle) { painter.SetStyle(inStyle); }
+        virtual bool DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA);
+        virtual bool CanDrawImage () const { return painter.CanDrawImage(); }
+        virtual long GetOutputSize () { return painter.GetOutputSize(); }
+
+    private:
+        // private member variables
+        Painter &painter;
+        PRect rect;
+
+    };
+
+    // A rows x columns grid of PPlot panels sharing one painter, so a page
+    // of charts is one document with one set of text metrics. Empty cells
+    // are left blank.
+    //
+    // With shared axes every panel of a column gets the x range of all of
+    // them, and every panel of a row the y range, so the panels can be
+    // compared at a glance. The grid keeps each panel's data range and
+    // scans it again only when that panel's data changed (container
+    // generation, sizes or PPlot::GetDataChangeCount; panels without
+    // mReuseLayout count a change on every draw). The panels autoscale to
+    // the union (PPlot::mSharedXRange and mSharedYRange, cleared after each
+    // draw), so log axes are still clipped and ranges rounded to ticks, and
+    // panels with mReuseLayout keep their ticks while the union stays the
+    // same. Fixed axis ends are kept.
+    //
+    // With more than one thread the panels are laid out and drawn in
+    // parallel into display lists, which are then replayed in order into the
+    // painter; text is measured with the painter, one call at a time.
+    class PlotGrid {
+    public:
+        PlotGrid(int rows, int columns): rows(rows), columns(columns), plots(rows * columns, nullptr) {}
+
+        // plot is not owned; nullptr empties the cell
+        void setPlot(int row, int column, PPlot *plot);
+        PPlot *getPlot(int row, int column) const;
+        int getRows() const { return rows; }
+        int getColumns() const { return columns; }
+
+        void setSpacing(int pixels) { spacing = pixels; }
+        void setShareX(bool share) { shareX = share; }
+        void setShareY(bool share) { shareY = share; }
+        void setThreadCount(int count) { threadCount = count; }
+
+        // the painter rectangle of a cell
+        PRect getCellRect(int row, int column, const Painter &painter) const;
+        // false if any panel failed to draw; the others are drawn regardless
+        bool draw(Painter &painter);
+        // panel data ranges scanned for shared axes so far, to check the reuse
+        long getRangeScans() const { return rangeScans; }
+
+    private:
+        // a panel's data ranges as of the last draw
+        struct PanelRanges {
+            const PPlot *plot = nullptr;
+            long generation = -1;
+            long dataChanges = -1;
+            vector<long> sizes; // x and y size of each plot
+            bool hasX = false;
+            float minX = 0, maxX = 0;
+            bool hasY = false;
+            float yFromX = 0, yToX = 0; // the x range the y range is for
+            float minY = 0, maxY = 0;
+        };
+        // calls body for each index in [0, count), on up to threadCount threads
+        void forEachPanel(size_t count, const function<void(size_t)> &body) const;
+        void shareRanges();
+        bool drawParallel(Painter &painter);
+        // private member variables
+        int rows;
+        int columns;
+        vector<PPlot *> plots; // row major
+        int spacing = 0; // [pixels] between cells
+        bool shareX = false;
+        bool shareY = false;
+        int threadCount = 1;
+        vector<PanelRanges> panelRanges; // by cell, for shareRanges
+        long rangeScans = 0;
+
+    };
+
+}
+
+
+#endif /* PlotGrid_h */
@@ -0,0 +1,191 @@
+//
+//  ProfilingPainter.cpp
+//
+//  A PPlot Painter Subclass that wraps another painter,
+//  forwards every call to it and records how often each
+//  method was called and how long it took.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "ProfilingPainter.h"
+#include <chrono>
+#include <cstdio>
+
+namespace SVGChart {
+    using namespace std;
+
+    namespace {
+        typedef chrono::steady_clock Clock;
+
+        long nanosecondsSince(Clock::time_point start) {
+            return (long)chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+        }
+    }
+
+    void ProfilingPainter::record(Method method, long nanoseconds) {
+        MethodStats &methodStats = stats[method];
+        methodStats.calls++;
+        methodStats.seconds += nanoseconds * 1e-9;
+        int bucket = 0;
+        while (bucket < kHistogramBuckets - 1 && nanoseconds >= 2L << bucket) {
+            bucket++;
+        }
+        methodStats.histogram[bucket]++;
+    }
+
+    void ProfilingPainter::DrawLine (float inX1, float inY1, float inX2, float inY2) {
+        Clock::time_point start = Clock::now();
+        CountingPainter::DrawLine(inX1, inY1, inX2, inY2);
+        record(kDrawLine, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::FillRect (int inX, int inY, int inW, int inH) {
+        Clock::time_point start = Clock::now();
+        CountingPainter::FillRect(inX, inY, inW, inH);
+        record(kFillRect, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::FillRects (const PRect *inRects, long inCount) {
+        Clock::time_point start = Clock::now();
+        CountingPainter::FillRects(inRects, inCount);
+        record(kFillRects, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::InvertRect (int inX, int inY, int inW, int inH) {
+        Clock::time_point start = Clock::now();
+        CountingPainter::InvertRect(inX, inY, inW, inH);
+        record(kInvertRect, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::SetClipRect (int inX, int inY, int inW, int inH) {
+        Clock::time_point start = Clock::now();
+        mPainter.SetClipRect(inX, inY, inW, inH);
+        record(kSetClipRect, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::SetLineColor (int inR, int inG, int inB) {
+        if (!hasLineColor || inR != lineRed || inG != lineGreen || inB != lineBlue) {
+            lineColorChanges++;
+            hasLineColor = true;
+            lineRed = inR; lineGreen = inG; lineBlue = inB;
+        }
+        Clock::time_point start = Clock::now();
+        mPainter.SetLineColor(inR, inG, inB);
+        record(kSetLineColor, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::SetFillColor (int inR, int inG, int inB) {
+        if (!hasFillColor || inR != fillRed || inG != fillGreen || inB != fillBlue) {
+            fillColorChanges++;
+            hasFillColor = true;
+            fillRed = inR; fillGreen = inG; fillBlue = inB;
+        }
+        Clock::time_point start = Clock::now();
+        mPainter.SetFillColor(inR, inG, inB);
+        record(kSetFillColor, nanosecondsSince(start));
+    }
+
+    long ProfilingPainter::CalculateTextDrawSize (const char *inString) {
+        Clock::time_point start = Clock::now();
+        long size = mPainter.CalculateTextDrawSize(inString);
+        record(kCalculateTextDrawSize, nanosecondsSince(start));
+        return size;
+    }
+
+    void ProfilingPainter::DrawText (int inX, int inY, const char *inString) {
+        Clock::time_point start = Clock::now();
+        CountingPainter::DrawText(inX, inY, inString);
+        record(kDrawText, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::DrawRotatedText (int inX, int inY, float inDegrees, const char *inString) {
+        Clock::time_point start = Clock::now();
+        CountingPainter::DrawRotatedText(inX, inY, inDegrees, inString);
+        record(kDrawRotatedText, nanosecondsSince(start));
+    }
+
+    void ProfilingPainter::SetStyle (const PStyle &inStyle) {
+        if (!hasStyle || inStyle.mFontSize != style.mFontSize || inStyle.mFont != style.mFont ||
+            inStyle.mPenWidth != style.mPenWidth || inStyle.mPenStyle != style.mPenStyle || inStyle.mVar != style.mVar) {
+            styleChanges++;
+            hasStyle = true;
+            style = inStyle;
+        }
+        Clock::time_point start = Clock::now();
+        mPainter.SetStyle(inStyle);
+        record(kSetStyle, nanosecondsSince(start));
+    }
+
+    bool ProfilingPainter::DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA) {
+        Clock::time_point start = Clock::now();
+        bool drawn = CountingPainter::DrawImage(inX, inY, inW, inH, inRGBA);
+        record(kDrawImage, nanosecondsSince(start));
+        return drawn;
+    }
+
+    const char *ProfilingPainter::methodName(Method method) {
+        static const char *names[kMethodCount] = {"DrawLine", "FillRect", "InvertRect", "SetClipRect", "SetLineColor",
+            "SetFillColor", "CalculateTextDrawSize", "DrawText", "DrawRotatedText", "SetStyle", "DrawImage", "FillRects"};
+        return method >= 0 && method < kMethodCount ? names[method] : "";
+    }
+
+    long ProfilingPainter::getPrimitiveCount() const {
+        return mPrimitiveCount;
+    }
+
+    void ProfilingPainter::reset() {
+        for (int i = 0; i < kMethodCount; i++) {
+            stats[i] = MethodStats();
+        }
+        lineColorChanges = fillColorChanges = styleChanges = 0;
+        mPrimitiveCount = 0;
+        hasLineColor = hasFillColor = hasStyle = false;
+    }
+
+    string ProfilingPainter::toJSON() const {
+        char buffer[128];
+        string json = "{\"methods\":{";
+        bool first = true;
+        for (int i = 0; i < kMethodCount; i++) {
+            const MethodStats &methodStats = stats[i];
+            if (methodStats.calls == 0) {
+                continue;
+            }
+            snprintf(buffer, sizeof(buffer), "%s\"%s\":{\"calls\":%ld,\"seconds\":%.9g,\"histogram_ns\":[",
+                     first ? "" : ",", methodName((Method)i), methodStats.calls, methodStats.seconds);
+            json += buffer;
+            first = false;
+            // trailing empty buckets are left out
+            int used = kHistogramBuckets;
+            while (used > 0 && methodStats.histogram[used - 1] == 0) {
+                used--;
+            }
+            for (int bucket = 0; bucket < used; bucket++) {
+                snprintf(buffer, sizeof(buffer), "%s%ld", bucket ? "," : "", methodStats.histogram[bucket]);
+                json += buffer;
+            }
+            json += "]}";
+        }
+        snprintf(buffer, sizeof(buffer), "},\"primitives\":%ld,\"line_color_changes\":%ld,\"fill_color_changes\":%ld,\"style_changes\":%ld}",
+                 getPrimitiveCount(), lineColorChanges, fillColorChanges, styleChanges);
+        json += buffer;
+        return json;
+    }
+}
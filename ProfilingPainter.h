@@ -0,0 +1,92 @@
+//
+//  ProfilingPainter.h
+//
+//  A PPlot Painter Subclass that wraps another painter,
+//  forwards every call to it and records how often each
+//  method was called and how long it took.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef ProfilingPainter_h
+#define ProfilingPainter_h
+
+#include <string>
+#include "PPlot.h"
+
+namespace SVGChart {
+    using namespace std;
+
+    class ProfilingPainter: public CountingPainter {
+    public:
+        enum Method {
+            kDrawLine, kFillRect, kInvertRect, kSetClipRect, kSetLineColor, kSetFillColor,
+            kCalculateTextDrawSize, kDrawText, kDrawRotatedText, kSetStyle, kDrawImage, kFillRects, kMethodCount
+        };
+        // bucket i counts calls that took [2^i, 2^(i+1)) ns, the last one everything slower
+        static const int kHistogramBuckets = 24;
+
+        struct MethodStats {
+            long calls = 0;
+            double seconds = 0;
+            long histogram[kHistogramBuckets] = {};
+        };
+
+        // painter must outlive this object
+        ProfilingPainter(Painter &painter): CountingPainter(painter) {}
+        // Overidden member functions
+        virtual void DrawLine (float inX1, float inY1, float inX2, float inY2);
+        virtual void FillRect (int inX, int inY, int inW, int inH);
+        virtual void FillRects (const PRect *inRects, long inCount);
+        virtual void InvertRect (int inX, int inY, int inW, int inH);
+        virtual void SetClipRect (int inX, int inY, int inW, int inH);
+        virtual void SetLineColor (int inR, int inG, int inB);
+        virtual void SetFillColor (int inR, int inG, int inB);
+        virtual long CalculateTextDrawSize (const char *inString);
+        virtual void DrawText (int inX, int inY, const char *inString);
+        virtual void DrawRotatedText (int inX, int inY, float inDegrees, const char *inString);
+        virtual void SetStyle (const PStyle &inStyle);
+        virtual bool DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA);
+
+        static const char *methodName(Method method);
+        const MethodStats &getStats(Method method) const { return stats[method]; }
+        // as CountingPainter and RenderProfile count them
+        long getPrimitiveCount() const;
+        // calls that actually changed the color or style; the rest were redundant
+        long getLineColorChanges() const { return lineColorChanges; }
+        long getFillColorChanges() const { return fillColorChanges; }
+        long getStyleChanges() const { return styleChanges; }
+        void reset();
+        string toJSON() const;
+
+    private:
+        void record(Method method, long nanoseconds);
+        // private member variables
+        MethodStats stats[kMethodCount];
+        long lineColorChanges = 0, fillColorChanges = 0, styleChanges = 0;
+        bool hasLineColor = false, hasFillColor = false, hasStyle = false;
+        int lineRed = 0, lineGreen = 0, lineBlue = 0, fillRed = 0, fillGreen = 0, fillBlue = 0;
+        PStyle style;
+
+    };
+
+}
+
+
+#endif /* ProfilingPainter_h */
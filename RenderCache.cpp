@@ -0,0 +1,216 @@
+//
+//  RenderCache.cpp
+//
+//  An on-disk cache of rendered SVG charts, keyed by the
+//  content hash of the PPlot and the painter size.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RenderCache.h"
+#include "SVGPainter.h"
+#include "TextMetrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace SVGChart {
+    using namespace std;
+    namespace fs = std::filesystem;
+
+    namespace {
+        // bump when the SVG output changes, so old entries are not served
+        const uint64_t kFormatVersion = 2;
+        const char *kExtension = ".svg";
+
+        bool parseKey(const string &name, uint64_t &key) {
+            if (name.size() != 16 + strlen(kExtension) || name.compare(16, string::npos, kExtension) != 0) {
+                return false;
+            }
+            key = 0;
+            for (int i = 0; i < 16; i++) {
+                char c = name[i];
+                int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+                if (digit < 0) {
+                    return false;
+                }
+                key = key << 4 | (uint64_t)digit;
+            }
+            return true;
+        }
+    }
+
+    RenderCache::RenderCache(const string &directory, size_t maxBytes): directory(directory), maxBytes(maxBytes) {
+        error_code error;
+        fs::create_directories(directory, error);
+        // oldest first, so pushing each to the front leaves the newest there
+        vector<pair<fs::file_time_type, uint64_t>> found;
+        for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+            uint64_t key;
+            if (!it->is_regular_file(error) || !parseKey(it->path().filename().string(), key)) {
+                continue;
+            }
+            found.push_back(make_pair(it->last_write_time(error), key));
+            entries[key].bytes = it->file_size(error);
+        }
+        sort(found.begin(), found.end());
+        for (const auto &file : found) {
+            recent.push_front(file.second);
+            Entry &entry = entries[file.second];
+            entry.position = recent.begin();
+            bytes += entry.bytes;
+        }
+        evict();
+    }
+
+    bool RenderCache::makeKey(const PPlot &plot, long width, long height, uint64_t &key) {
+        uint64_t hash;
+        if (!plot.GetContentHash(hash)) {
+            return false;
+        }
+        ContentHasher hasher;
+        hasher.AddBytes(&kFormatVersion, sizeof(kFormatVersion));
+        hasher.AddBytes(&hash, sizeof(hash));
+        // SVGPainter measures text with the shared tables, which a metrics
+        // file can change
+        uint64_t metrics = TextMetrics::shared().fingerprint();
+        hasher.AddBytes(&metrics, sizeof(metrics));
+        hasher.AddLong(width);
+        hasher.AddLong(height);
+        key = hasher.GetHash();
+        return true;
+    }
+
+    string RenderCache::render(PPlot &plot, long width, long height) {
+        uint64_t key;
+        if (!makeKey(plot, width, height, key)) {
+            stats.uncacheable++;
+            SVGPainter painter(width, height);
+            plot.Draw(painter);
+            return painter.getContent();
+        }
+        string svg;
+        if (get(key, svg)) {
+            return svg;
+        }
+        SVGPainter painter(width, height);
+        plot.Draw(painter);
+        svg = painter.getContent();
+        put(key, svg);
+        return svg;
+    }
+
+    bool RenderCache::get(uint64_t key, string &svg) {
+        auto found = entries.find(key);
+        if (found == entries.end()) {
+            stats.misses++;
+            return false;
+        }
+        ifstream file(pathFor(key), ios::binary);
+        if (!file) {
+            // deleted behind our back, e.g. evicted by another process
+            remove(key);
+            stats.misses++;
+            return false;
+        }
+        stringstream content;
+        content << file.rdbuf();
+        svg = content.str();
+        // files are only ever replaced whole, so this is a complete one
+        bytes = bytes - found->second.bytes + svg.size();
+        found->second.bytes = svg.size();
+        recent.splice(recent.begin(), recent, found->second.position);
+        error_code error;
+        fs::last_write_time(pathFor(key), fs::file_time_type::clock::now(), error);
+        stats.hits++;
+        return true;
+    }
+
+    void RenderCache::put(uint64_t key, const string &svg) {
+        if (svg.size() > maxBytes) {
+            return;
+        }
+        if (entries.count(key)) {
+            remove(key);
+        }
+        // a name no other process picks, which the constructor doesn't list
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%08x.tmp", (unsigned int)random_device()());
+        string temporary = pathFor(key) + suffix;
+        ofstream file(temporary, ios::binary);
+        file.write(svg.data(), svg.size());
+        file.close();
+        error_code error;
+        if (file) {
+            fs::rename(temporary, pathFor(key), error);
+        }
+        if (!file || error) {
+            fs::remove(temporary, error);
+            return;
+        }
+        recent.push_front(key);
+        entries[key] = Entry{svg.size(), recent.begin()};
+        bytes += svg.size();
+        evict();
+    }
+
+    void RenderCache::clear() {
+        while (!recent.empty()) {
+            remove(recent.back());
+        }
+    }
+
+    string RenderCache::toJSON() const {
+        char buffer[192];
+        snprintf(buffer, sizeof(buffer),
+                 "{\"hits\":%ld,\"misses\":%ld,\"uncacheable\":%ld,\"evictions\":%ld,\"entries\":%zu,\"bytes\":%zu}",
+                 stats.hits, stats.misses, stats.uncacheable, stats.evictions, entries.size(), bytes);
+        return buffer;
+    }
+
+    string RenderCache::pathFor(uint64_t key) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx%s", (unsigned long long)key, kExtension);
+        return (fs::path(directory) / name).string();
+    }
+
+    void RenderCache::remove(uint64_t key) {
+        auto found = entries.find(key);
+        if (found == entries.end()) {
+            return;
+        }
+        error_code error;
+        fs::remove(pathFor(key), error);
+        bytes -= found->second.bytes;
+        recent.erase(found->second.position);
+        entries.erase(found);
+    }
+
+    void RenderCache::evict() {
+        while (bytes > maxBytes && !recent.empty()) {
+            remove(recent.back());
+            stats.evictions++;
+        }
+    }
+}
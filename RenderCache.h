@@ -0,0 +1,92 @@
+//
+//  RenderCache.h
+//
+//  An on-disk cache of rendered SVG charts, keyed by the
+//  content hash of the PPlot and the painter size.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef RenderCache_h
+#define RenderCache_h
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "PPlot.h"
+
+namespace SVGChart {
+    using namespace std;
+
+    // Every entry is one <key>.svg file in the cache directory, so a cache
+    // survives restarts and can be shared by processes that render the same
+    // charts. Files are written under a temporary name and renamed into
+    // place, so a reader never sees half of one. When the files exceed the
+    // size limit the least recently used ones are deleted; hits touch the
+    // file time, which is how the order is restored on the next start. Not
+    // thread safe.
+    class RenderCache {
+    public:
+        struct Stats {
+            long hits = 0;
+            long misses = 0;
+            long uncacheable = 0; // plots without a content hash, always rendered
+            long evictions = 0;
+        };
+
+        // Creates directory if needed and picks up the entries already in it.
+        RenderCache(const string &directory, size_t maxBytes);
+
+        // plot drawn into a width x height SVGPainter, from the cache when possible
+        string render(PPlot &plot, long width, long height);
+        // covers the plot, the size and the loaded text metrics; false if
+        // the plot can't be hashed, see PPlot::GetContentHash
+        static bool makeKey(const PPlot &plot, long width, long height, uint64_t &key);
+        bool get(uint64_t key, string &svg);
+        void put(uint64_t key, const string &svg);
+        void clear(); // deletes all entries
+
+        const Stats &getStats() const { return stats; }
+        size_t getBytes() const { return bytes; }
+        size_t getEntryCount() const { return entries.size(); }
+        string toJSON() const;
+
+    private:
+        struct Entry {
+            size_t bytes;
+            list<uint64_t>::iterator position; // in recent
+        };
+        string pathFor(uint64_t key) const;
+        void remove(uint64_t key);
+        void evict();
+        // private member variables
+        string directory;
+        size_t maxBytes;
+        size_t bytes = 0;
+        list<uint64_t> recent; // most recently used first
+        unordered_map<uint64_t, Entry> entries;
+        Stats stats;
+
+    };
+
+}
+
+
+#endif /* RenderCache_h */
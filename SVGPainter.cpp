@@ -26,6 +26,8 @@
 //  OTHER DEALINGS IN THE SOFTWARE.
 
 #include "SVGPainter.h"
+#include "PNGEncoder.h"
+#include "TextMetrics.h"
 #include <cstring>
 #include <fstream>
 
@@ -55,6 +57,32 @@ namespace SVGChart {
         svgContent << fillGreen << "," << fillBlue << ")" << "\" />\n";
     }
     
+    void SVGPainter::FillRects (const PRect *inRects, long inCount) {
+        // one path for all of them, they share the fill color
+        bool empty = true;
+        for (long i = 0; i < inCount; i++) {
+            PRect rect = inRects[i];
+            if (rect.mW == 0 || rect.mH == 0) {
+                continue;
+            }
+            // all drawn the same way round, so overlaps don't cancel out
+            if (rect.mW < 0) {
+                rect.mX += rect.mW;
+                rect.mW = -rect.mW;
+            }
+            if (rect.mH < 0) {
+                rect.mY += rect.mH;
+                rect.mH = -rect.mH;
+            }
+            svgContent << (empty ? "<path d=\"" : " ") << "M" << rect.mX << " " << rect.mY << "h" << rect.mW;
+            svgContent << "v" << rect.mH << "h" << -rect.mW << "z";
+            empty = false;
+        }
+        if (!empty) {
+            svgContent << "\" fill=\"" << "rgb(" << fillRed << "," << fillGreen << "," << fillBlue << ")" << "\" />\n";
+        }
+    }
+
     void SVGPainter::InvertRect (int inX, int inY, int inW, int inH) {
         svgContent << "<rect x=\"" << inX << "\" y=\"" << inY;
         svgContent << "\" width=\"" << inW << "\" height=\"" << inH;
@@ -63,50 +91,100 @@ namespace SVGChart {
         svgContent << ")" << "\" />\n";
     }
     
+    // Everything drawn until the next SetClipRect goes into a group
+    // that references this clip path.
     void SVGPainter::SetClipRect (int inX, int inY, int inW, int inH) {
-        svgContent << "<clipPath>\n";
-        FillRect(inX, inY, inW, inH);
+        if (clipGroupOpen) {
+            svgContent << "</g>\n";
+        }
+        clipCount++;
+        svgContent << "<clipPath id=\"clip" << clipCount << "\">\n";
+        svgContent << "<rect x=\"" << inX << "\" y=\"" << inY;
+        svgContent << "\" width=\"" << inW << "\" height=\"" << inH << "\" />\n";
         svgContent << "</clipPath>\n";
+        svgContent << "<g clip-path=\"url(#clip" << clipCount << ")\">\n";
+        clipGroupOpen = true;
     }
     
-    // The following array & function snippet are translated to C++ from this source
-    // https://stackoverflow.com/a/42816496/281461
-    const int LCARS_CHAR_SIZE_ARRAY[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 17, 26, 46, 63, 42, 105, 45, 20, 25, 25, 47, 39, 21, 34, 26, 36, 36, 28, 36, 36, 36, 36, 36, 36, 36, 36, 27, 27, 36, 35, 36, 35, 65, 42, 43, 42, 44, 35, 34, 43, 46, 25, 39, 40, 31, 59, 47, 43, 41, 43, 44, 39, 28, 44, 43, 65, 37, 39, 34, 37, 42, 37, 50, 37, 32, 43, 43, 39, 43, 40, 30, 42, 45, 23, 25, 39, 23, 67, 45, 41, 43, 42, 30, 40, 28, 45, 33, 52, 33, 36, 31, 39, 26, 39, 55};
-    
     long SVGPainter::CalculateTextDrawSize (const char *inString) {
-        float width = 0;
-        float scaleFactor = fontSize / 100.0;;
-        
-        auto length = strlen(inString);
-        for (unsigned long i = 0; i < length; i++) {
-            if (inString[i] > 126) {
-                width += 65; // default increase for unknown characters
-            }
-            width = width + LCARS_CHAR_SIZE_ARRAY[(int)inString[i]];
-        }
         float padding = 25.0; // 25 is a little bit of padding
-        return long(width * scaleFactor + padding);
+        return long(TextMetrics::shared().measure(fontName, fontSize, inString) + padding);
+    }
+    
+    void SVGPainter::SetStyle (const PStyle &inStyle) {
+        if (useStyleFonts) {
+            fontSize = inStyle.mFontSize;
+            fontName = inStyle.mFont;
+        }
+    }
+    
+    void SVGPainter::writeFontAttributes() {
+        if (!useStyleFonts) {
+            return;
+        }
+        svgContent << " font-size=\"" << fontSize << "\"";
+        if (!fontName.empty()) {
+            svgContent << " font-family=\"" << fontName << "\"";
+        }
     }
     
     void SVGPainter::DrawText (int inX, int inY, const char *inString) {
-        svgContent << "<text x=\"" << inX << "\" y=\"" << inY;
-        svgContent << "\" fill=\"" << "rgb(" << lineRed << ",";
+        svgContent << "<text x=\"" << inX << "\" y=\"" << inY << "\"";
+        writeFontAttributes();
+        svgContent << " fill=\"" << "rgb(" << lineRed << ",";
         svgContent << lineGreen << "," << lineBlue << ")" << "\">\n";
         svgContent << inString << "</text>\n";
     }
     
     void SVGPainter::DrawRotatedText (int inX, int inY, float inDegrees, const char *inString) {
-        svgContent << "<text x=\"" << inX << "\" y=\"" << inY << "\" transform=";
+        svgContent << "<text x=\"" << inX << "\" y=\"" << inY << "\"";
+        writeFontAttributes();
+        svgContent << " transform=";
         svgContent << "\"rotate(" << inDegrees;
         svgContent << "," << inX << "," << inY << ")\">";
         svgContent << inString << "</text>\n";
     }
 
+    // The image is embedded as a base64 PNG data URI.
+    bool SVGPainter::DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA) {
+        vector<unsigned char> png;
+        if (!EncodePNG(inW, inH, inRGBA, png)) {
+            return false;
+        }
+        const char *base64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        string encoded;
+        encoded.reserve((png.size() + 2) / 3 * 4);
+        for (size_t i = 0; i < png.size(); i += 3) {
+            unsigned long chunk = (unsigned long)png[i] << 16;
+            if (i + 1 < png.size()) chunk |= (unsigned long)png[i + 1] << 8;
+            if (i + 2 < png.size()) chunk |= png[i + 2];
+            encoded += base64[(chunk >> 18) & 63];
+            encoded += base64[(chunk >> 12) & 63];
+            encoded += i + 1 < png.size() ? base64[(chunk >> 6) & 63] : '=';
+            encoded += i + 2 < png.size() ? base64[chunk & 63] : '=';
+        }
+        svgContent << "<image x=\"" << inX << "\" y=\"" << inY;
+        svgContent << "\" width=\"" << inW << "\" height=\"" << inH;
+        svgContent << "\" style=\"image-rendering:pixelated\"";
+        svgContent << " xmlns:xlink=\"http://www.w3.org/1999/xlink\"";
+        svgContent << " xlink:href=\"data:image/png;base64," << encoded << "\" />\n";
+        return true;
+    }
+
     void SVGPainter::writeFile(string filePath) {
         ofstream outFile;
         outFile.open(filePath);
-        outFile << svgContent.rdbuf();
-        outFile << "</svg>\n" << endl;
+        outFile << getContent();
         outFile.close();
     }
+
+    string SVGPainter::getContent() const {
+        string content = svgContent.str();
+        if (clipGroupOpen) {
+            content += "</g>\n";
+        }
+        content += "</svg>\n\n";
+        return content;
+    }
+
 }
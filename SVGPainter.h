@@ -41,6 +41,7 @@ namespace SVGChart {
         // Overidden member functions
         virtual void DrawLine (float inX1, float inY1, float inX2, float inY2);
         virtual void FillRect (int inX, int inY, int inW, int inH);
+        virtual void FillRects (const PRect *inRects, long inCount);
         virtual void InvertRect (int inX, int inY, int inW, int inH);
         virtual void SetClipRect (int inX, int inY, int inW, int inH);
         virtual long GetWidth () const { return _width; }
@@ -55,14 +56,27 @@ namespace SVGChart {
         virtual long GetFontHeight () const { return fontSize; }
         virtual void DrawText (int inX, int inY, const char *inString);
         virtual void DrawRotatedText (int inX, int inY, float inDegrees, const char *inString);
-        virtual void SetStyle ([[maybe_unused]] const PStyle &inStyle){}
+        virtual void SetStyle (const PStyle &inStyle);
+        virtual bool DrawImage (int inX, int inY, int inW, int inH, const unsigned char *inRGBA);
+        virtual bool CanDrawImage () const { return true; }
+        virtual long GetOutputSize () { return (long)svgContent.tellp(); }
         void writeFile(string filePath);
+        // the complete document, as writeFile writes it
+        string getContent() const;
+        // Take font size and family from PStyle and write them on the text
+        // elements. Off by default, all text is then measured at 16px.
+        void setUseStyleFonts(bool use) { useStyleFonts = use; }
         // public member variables
         
     private:
+        void writeFontAttributes();
         // private member variables
         int lineRed = 0, lineGreen = 0, lineBlue = 0, fillRed = 0, fillGreen = 0, fillBlue = 0;
         int fontSize = 16;
+        string fontName; // empty: the built in metrics
+        bool useStyleFonts = false;
+        int clipCount = 0; // clip paths written so far, used for unique ids
+        bool clipGroupOpen = false;
         stringstream svgContent;
         long _width;
         long _height;
@@ -0,0 +1,265 @@
+//
+//  TextMetrics.cpp
+//
+//  Text width measurement for painters that cannot ask a font
+//  renderer, such as SVGPainter.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "TextMetrics.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace SVGChart {
+    using namespace std;
+
+    namespace {
+        // The built in widths are translated to C++ from this source
+        // https://stackoverflow.com/a/42816496/281461
+        const int LCARS_CHAR_SIZE_ARRAY[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 17, 26, 46, 63, 42, 105, 45, 20, 25, 25, 47, 39, 21, 34, 26, 36, 36, 28, 36, 36, 36, 36, 36, 36, 36, 36, 27, 27, 36, 35, 36, 35, 65, 42, 43, 42, 44, 35, 34, 43, 46, 25, 39, 40, 31, 59, 47, 43, 41, 43, 44, 39, 28, 44, 43, 65, 37, 39, 34, 37, 42, 37, 50, 37, 32, 43, 43, 39, 43, 40, 30, 42, 45, 23, 25, 39, 23, 67, 45, 41, 43, 42, 30, 40, 28, 45, 33, 52, 33, 36, 31, 39, 26, 39, 55};
+
+        const unsigned long kReplacementCharacter = 0xFFFD;
+
+        // Decodes one UTF-8 sequence starting at text[pos] and advances pos.
+        unsigned long nextCodePoint(const unsigned char *text, size_t length, size_t &pos) {
+            unsigned char lead = text[pos++];
+            if (lead < 0x80) {
+                return lead;
+            }
+            int extra;
+            unsigned long codePoint;
+            if ((lead & 0xE0) == 0xC0) {
+                extra = 1;
+                codePoint = lead & 0x1F;
+            } else if ((lead & 0xF0) == 0xE0) {
+                extra = 2;
+                codePoint = lead & 0x0F;
+            } else if ((lead & 0xF8) == 0xF0) {
+                extra = 3;
+                codePoint = lead & 0x07;
+            } else {
+                return kReplacementCharacter;
+            }
+            if (pos + extra > length) {
+                pos = length;
+                return kReplacementCharacter;
+            }
+            for (int i = 0; i < extra; i++) {
+                if ((text[pos] & 0xC0) != 0x80) {
+                    return kReplacementCharacter; // resync on the offending byte
+                }
+                codePoint = (codePoint << 6) | (text[pos++] & 0x3F);
+            }
+            return codePoint;
+        }
+
+        // FNV-1a over the string, mixed with font and size
+        size_t hashKey(int font, int fontSize, const char *text, size_t length) {
+            size_t h = 2166136261u;
+            for (size_t i = 0; i < length; i++) {
+                h = (h ^ (unsigned char)text[i]) * 16777619u;
+            }
+            h = (h ^ (size_t)font) * 16777619u;
+            h = (h ^ (size_t)fontSize) * 16777619u;
+            return h;
+        }
+
+        // FNV-1a, 64 bit
+        void addBytes(uint64_t &hash, const void *data, size_t size) {
+            const unsigned char *bytes = (const unsigned char *)data;
+            for (size_t i = 0; i < size; i++) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+
+        // other widths sorted by code point, since map order isn't stable
+        uint64_t fingerprintFonts(const vector<FontWidthTable> &fonts) {
+            uint64_t hash = 14695981039346656037ull;
+            for (const FontWidthTable &font : fonts) {
+                uint64_t nameSize = font.name.size();
+                addBytes(hash, &nameSize, sizeof(nameSize));
+                addBytes(hash, font.name.data(), font.name.size());
+                addBytes(hash, &font.defaultWidth, sizeof(font.defaultWidth));
+                addBytes(hash, font.asciiWidths, sizeof(font.asciiWidths));
+                vector<pair<unsigned long, float>> others(font.otherWidths.begin(), font.otherWidths.end());
+                sort(others.begin(), others.end());
+                for (const auto &other : others) {
+                    uint64_t code = other.first;
+                    addBytes(hash, &code, sizeof(code));
+                    addBytes(hash, &other.second, sizeof(other.second));
+                }
+            }
+            return hash;
+        }
+
+        bool parseCode(const string &token, unsigned long &code) {
+            const char *start = token.c_str();
+            int base = 10;
+            if (token.size() > 2 && (token[0] == 'U' || token[0] == 'u') && token[1] == '+') {
+                start += 2;
+                base = 16;
+            }
+            char *end;
+            code = strtoul(start, &end, base);
+            return end != start && *end == 0;
+        }
+    }
+
+    FontWidthTable::FontWidthTable() {
+        for (int i = 0; i < 128; i++) {
+            asciiWidths[i] = -1;
+        }
+    }
+
+    float FontWidthTable::width(unsigned long codePoint) const {
+        if (codePoint < 128) {
+            return asciiWidths[codePoint] >= 0 ? asciiWidths[codePoint] : defaultWidth;
+        }
+        auto found = otherWidths.find(codePoint);
+        return found != otherWidths.end() ? found->second : defaultWidth;
+    }
+
+    TextMetrics::TextMetrics(): cache(kCacheSize) {
+        FontWidthTable builtIn;
+        builtIn.name = "LCARS";
+        for (int i = 0; i < 127; i++) {
+            builtIn.asciiWidths[i] = LCARS_CHAR_SIZE_ARRAY[i];
+        }
+        fonts.push_back(builtIn);
+        fontsFingerprint = fingerprintFonts(fonts);
+    }
+
+    TextMetrics &TextMetrics::shared() {
+        static TextMetrics instance;
+        return instance;
+    }
+
+    bool TextMetrics::loadMetricsFile(const string &filePath) {
+        ifstream file(filePath);
+        if (!file) {
+            return false;
+        }
+        vector<FontWidthTable> loaded;
+        string line;
+        while (getline(file, line)) {
+            size_t comment = line.find('#');
+            if (comment != string::npos) {
+                line.erase(comment);
+            }
+            istringstream fields(line);
+            string key, value;
+            if (!(fields >> key)) {
+                continue; // blank line
+            }
+            if (!(fields >> value)) {
+                return false;
+            }
+            if (key == "font") {
+                loaded.push_back(FontWidthTable());
+                loaded.back().name = value;
+                continue;
+            }
+            char *end;
+            float width = strtof(value.c_str(), &end);
+            unsigned long code;
+            if (loaded.empty() || *end != 0) {
+                return false;
+            }
+            if (key == "default") {
+                loaded.back().defaultWidth = width;
+            } else if (!parseCode(key, code)) {
+                return false;
+            } else if (code < 128) {
+                loaded.back().asciiWidths[code] = width;
+            } else {
+                loaded.back().otherWidths[code] = width;
+            }
+        }
+        for (const FontWidthTable &font : loaded) {
+            addFont(font);
+        }
+        return true;
+    }
+
+    void TextMetrics::addFont(const FontWidthTable &font) {
+        lock_guard<mutex> guard(lock);
+        int index = findFontIndex(font.name);
+        if (index > 0 || (index == 0 && font.name == fonts[0].name)) {
+            fonts[index] = font;
+        } else {
+            fonts.push_back(font);
+        }
+        // cached widths may belong to the replaced table
+        cache.assign(kCacheSize, CacheEntry());
+        fontsFingerprint = fingerprintFonts(fonts);
+    }
+
+    uint64_t TextMetrics::fingerprint() const {
+        lock_guard<mutex> guard(lock);
+        return fontsFingerprint;
+    }
+
+    FontWidthTable TextMetrics::findFont(const string &name) const {
+        lock_guard<mutex> guard(lock);
+        return fonts[findFontIndex(name)];
+    }
+
+    int TextMetrics::findFontIndex(const string &name) const {
+        for (size_t i = 0; i < fonts.size(); i++) {
+            if (fonts[i].name == name) {
+                return (int)i;
+            }
+        }
+        return 0;
+    }
+
+    float TextMetrics::computeWidth(const FontWidthTable &font, int fontSize, const char *text, size_t length) const {
+        float width = 0;
+        float scaleFactor = fontSize / 100.0;
+        const unsigned char *bytes = (const unsigned char *)text;
+        size_t pos = 0;
+        while (pos < length) {
+            width += font.width(nextCodePoint(bytes, length, pos));
+        }
+        return width * scaleFactor;
+    }
+
+    float TextMetrics::measure(const string &font, int fontSize, const char *text) {
+        size_t length = strlen(text);
+        lock_guard<mutex> guard(lock);
+        int index = findFontIndex(font);
+        CacheEntry &entry = cache[hashKey(index, fontSize, text, length) & (kCacheSize - 1)];
+        if (entry.used && entry.font == index && entry.fontSize == fontSize &&
+            entry.text.size() == length && memcmp(entry.text.data(), text, length) == 0) {
+            hits++;
+            return entry.width;
+        }
+        misses++;
+        entry.used = true;
+        entry.font = index;
+        entry.fontSize = fontSize;
+        entry.text.assign(text, length);
+        entry.width = computeWidth(fonts[index], fontSize, text, length);
+        return entry.width;
+    }
+}
@@ -0,0 +1,102 @@
+//
+//  TextMetrics.h
+//
+//  Text width measurement for painters that cannot ask a font
+//  renderer, such as SVGPainter. Widths come from per font tables
+//  (a built in one plus any loaded from a metrics file) and are
+//  cached per font, size and string.
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef TextMetrics_h
+#define TextMetrics_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace SVGChart {
+    using namespace std;
+
+    // Advance widths of one font in 1/100 of the font size.
+    struct FontWidthTable {
+        string name;
+        float defaultWidth = 65; // characters missing from the table
+        float asciiWidths[128]; // negative: use defaultWidth
+        unordered_map<unsigned long, float> otherWidths; // code points >= 128
+
+        FontWidthTable();
+        float width(unsigned long codePoint) const;
+    };
+
+    class TextMetrics {
+    public:
+        TextMetrics();
+
+        // The instance SVGPainter measures with.
+        static TextMetrics &shared();
+
+        // Reads a metrics file and adds (or replaces) its fonts. The format is
+        // line based, '#' starts a comment:
+        //   font <name>        starts a new table, later lines fill it
+        //   default <width>    width of characters not listed
+        //   <code> <width>     code is decimal or U+hex, e.g. 65 or U+00E9
+        // Returns false if the file can't be read or has a malformed line.
+        bool loadMetricsFile(const string &filePath);
+        void addFont(const FontWidthTable &font);
+        // Falls back to the built in table for empty or unknown names. Returns
+        // a copy, since addFont may replace or move the stored tables.
+        FontWidthTable findFont(const string &name) const;
+
+        // Width in pixels of a UTF-8 string drawn at fontSize. Invalid
+        // bytes count as one unknown character each.
+        float measure(const string &font, int fontSize, const char *text);
+
+        // Hash of the font tables; equal tables give equal values, in any
+        // process. Changes when loadMetricsFile or addFont changes a table.
+        uint64_t fingerprint() const;
+
+        long cacheHits() const { return hits; }
+        long cacheMisses() const { return misses; }
+
+    private:
+        int findFontIndex(const string &name) const;
+        float computeWidth(const FontWidthTable &font, int fontSize, const char *text, size_t length) const;
+
+        struct CacheEntry {
+            bool used = false;
+            int font = 0;
+            int fontSize = 0;
+            float width = 0;
+            string text;
+        };
+        static const size_t kCacheSize = 1024; // direct mapped, power of two
+
+        vector<FontWidthTable> fonts; // fonts[0] is the built in table
+        vector<CacheEntry> cache;
+        uint64_t fontsFingerprint = 0;
+        long hits = 0, misses = 0;
+        mutable mutex lock;
+    };
+}
+
+#endif /* TextMetrics_h */
@@ -0,0 +1,584 @@
+//
+//  bench.cpp
+//
+//  Benchmarks for SVGChart. Prints one line per case with the
+//  time per iteration.
+//
+//  The render suite times PPlot::Draw into an SVGPainter end to end for
+//  a grid of workloads. Options:
+//    --json           print the render suite only, as JSON
+//    --max-points N   largest points per series to run (default 1e6, up to 1e8)
+//    --filter TEXT    only run render cases whose name contains TEXT
+//
+
+#include "PPlot.h"
+#include "SVGPainter.h"
+#include "DisplayListPainter.h"
+#include "RenderCache.h"
+#include "PlotGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using namespace SVGChart;
+
+// Runs body until at least minSeconds have passed and returns seconds per run.
+template <typename Body>
+static double timeIt(Body body, double minSeconds = 0.2) {
+    using Clock = chrono::steady_clock;
+    long runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    do {
+        body();
+        runs++;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed / runs;
+}
+
+// Time axis ticks for spans from microseconds to decades, on data that sits
+// at a 2024 epoch so the calendar math is exercised.
+static void benchTimeTicks() {
+    const double spans[] = {1e-6, 1e-3, 1, 60, 3600, 86400, 86400 * 30, 86400 * 365.2425, 86400 * 365.2425 * 30};
+    const char *names[] = {"1us", "1ms", "1s", "1min", "1h", "1d", "30d", "1y", "30y"};
+    for (int i = 0; i < 9; i++) {
+        AxisSetup axis;
+        axis.mTimeScale = true;
+        axis.mTimeOrigin = 1715950000.25;
+        axis.mMin = 0;
+        axis.mMax = axis.TimeValue(axis.mTimeOrigin + spans[i]);
+        TimeTickIterator iterator;
+        iterator.SetAxisSetup(&axis);
+        // about 8 labels, as on a 600 pixel wide chart
+        iterator.InitFromRanges(axis.mMax - axis.mMin, 300, 8, axis.mTickInfo);
+        TickList ticks;
+        double seconds = timeIt([&]() { iterator.FillTicks(ticks); });
+        long major = 0;
+        while (major < ticks.GetCount() - 1 && !ticks.GetTick(major).mIsMajor) {
+            major++;
+        }
+        printf("time ticks %-5s %4ld ticks  %8.0f ns/axis  %6.1f ns/tick  first label %s\n", names[i],
+               ticks.GetCount(), seconds * 1e9, seconds * 1e9 / ticks.GetCount(), ticks.GetLabel(major));
+    }
+}
+
+// Summing a series through PlotDataBase::GetValue (two virtual calls per
+// element) and through a PlotDataSpan fetched once.
+static void benchDataAccess() {
+    const long size = 1000000;
+    PlotData real;
+    for (long i = 0; i < size; i++) {
+        real.push_back(i * 0.5f);
+    }
+    CalculatedData affine(0, 0.5f, size);
+    CalculatedPlotData calculated(&affine);
+    const PlotDataBase *series[] = {&real, &calculated};
+    const char *names[] = {"real", "calculated"};
+    for (int s = 0; s < 2; s++) {
+        const PlotDataBase &data = *series[s];
+        volatile float sink = 0;
+        double perElement = timeIt([&]() {
+            float sum = 0;
+            for (long i = 0; i < data.GetSize(); i++) {
+                sum += data.GetValue(i);
+            }
+            sink = sum;
+        });
+        double span = timeIt([&]() {
+            PlotDataSpan values = data.GetSpan();
+            float sum = 0;
+            for (long i = 0; i < values.GetSize(); i++) {
+                sum += values[i];
+            }
+            sink = sum;
+        });
+        (void)sink;
+        printf("data access %-10s GetValue %6.2f ns/value  span %6.2f ns/value  %.1fx\n", names[s],
+               perElement * 1e9 / size, span * 1e9 / size, perElement / span);
+    }
+}
+
+// Subclasses are not matched by the specialized line kernel, so drawing
+// through these takes the generic path with virtual Transform calls.
+struct GenericLinTrafo : public LinTrafo {};
+struct GenericLogTrafo : public LogTrafo {};
+
+// LineDataDrawer::DrawData on a million points through the specialized
+// kernel and through the generic loop, for lin and log y trafos.
+static void benchLineKernel() {
+    const long size = 1000000;
+    PlotData x, y;
+    for (long i = 0; i < size; i++) {
+        x.push_back(i * 0.001f);
+        y.push_back(2 + sinf(i * 0.001f));
+    }
+    AxisSetup xAxis;
+    xAxis.mMin = 0;
+    xAxis.mMax = size * 0.001f;
+    PRect rect;
+    rect.mX = 50;
+    rect.mY = 20;
+    rect.mW = 700;
+    rect.mH = 540;
+    LinTrafo xLin, yLin;
+    LogTrafo yLog;
+    GenericLinTrafo xGeneric, yGenericLin;
+    GenericLogTrafo yGenericLog;
+    LinTrafo *xs[] = {&xLin, &xGeneric};
+    xLin.mSlope = xGeneric.mSlope = rect.mW / xAxis.mMax;
+    xLin.mOffset = xGeneric.mOffset = rect.mX;
+    yLin.mSlope = yGenericLin.mSlope = -rect.mH / 3.0f;
+    yLin.mOffset = yGenericLin.mOffset = rect.mY + rect.mH;
+    yLog.mSlope = yGenericLog.mSlope = -(float)rect.mH;
+    yLog.mOffset = yGenericLog.mOffset = rect.mY + rect.mH;
+    Trafo *ys[2][2] = {{&yLin, &yGenericLin}, {&yLog, &yGenericLog}};
+    const char *trafoNames[] = {"lin", "log"};
+    LineDataDrawer line;
+    DotDataDrawer dots;
+    LineDataDrawer *drawers[] = {&line, &dots};
+    const char *drawerNames[] = {"line", "dot"};
+    PlotDataSelection selection;
+    DummyPainter painter(800, 600);
+    for (int d = 0; d < 2; d++) {
+        for (int t = 0; t < 2; t++) {
+            double seconds[2];
+            for (int k = 0; k < 2; k++) {
+                drawers[d]->SetXTrafo(xs[k]);
+                drawers[d]->SetYTrafo(ys[t][k]);
+                seconds[k] = timeIt([&]() { drawers[d]->DrawData(x, y, selection, xAxis, rect, painter); });
+            }
+            printf("line kernel %-4s %s  specialized %6.2f ns/point  generic %6.2f ns/point  %.2fx\n", drawerNames[d],
+                   trafoNames[t], seconds[0] * 1e9 / size, seconds[1] * 1e9 / size, seconds[1] / seconds[0]);
+        }
+    }
+}
+
+// Emits the rects of a batch one element at a time, as bars were drawn
+// before FillRects.
+class RectByRectPainter: public SVGPainter {
+public:
+    RectByRectPainter(long width, long height): SVGPainter(width, height) {}
+    virtual void FillRects (const PRect *inRects, long inCount) { Painter::FillRects(inRects, inCount); }
+};
+
+// BarDataDrawer::DrawData into an SVGPainter for fewer bars than pixel
+// columns and for many more, where the bars of a column are merged.
+static void benchBars() {
+    const long sizes[] = {500, 1000000};
+    PRect rect;
+    rect.mX = 50;
+    rect.mY = 20;
+    rect.mW = 700;
+    rect.mH = 540;
+    for (long size : sizes) {
+        PlotData x, y;
+        for (long i = 0; i < size; i++) {
+            x.push_back((float)i);
+            y.push_back(sinf(i * 0.0001f) + 0.5f * sinf(i * 0.37f));
+        }
+        AxisSetup xAxis;
+        xAxis.mMin = 0;
+        xAxis.mMax = (float)size;
+        LinTrafo xTrafo, yTrafo;
+        xTrafo.mSlope = rect.mW / xAxis.mMax;
+        xTrafo.mOffset = rect.mX;
+        yTrafo.mSlope = -rect.mH / 3.0f;
+        yTrafo.mOffset = rect.mY + rect.mH / 2.0f;
+        BarDataDrawer bars;
+        bars.SetXTrafo(&xTrafo);
+        bars.SetYTrafo(&yTrafo);
+        PlotDataSelection selection;
+        size_t bytes[2] = {};
+        long shapes = 0;
+        double seconds[2];
+        seconds[0] = timeIt([&]() {
+            RectByRectPainter painter(800, 600);
+            bars.DrawData(x, y, selection, xAxis, rect, painter);
+            bytes[0] = painter.getContent().size();
+        });
+        seconds[1] = timeIt([&]() {
+            SVGPainter painter(800, 600);
+            bars.DrawData(x, y, selection, xAxis, rect, painter);
+            bytes[1] = painter.getContent().size();
+        });
+        DummyPainter dummy(800, 600);
+        bars.DrawData(x, y, selection, xAxis, rect, dummy);
+        shapes = dummy.mRectCount;
+        printf("bars %8ld  %ld rects  rect elements %7.2f ms %8zu bytes  one path %7.2f ms %8zu bytes  %.2fx\n", size,
+               shapes, seconds[0] * 1e3, bytes[0], seconds[1] * 1e3, bytes[1], seconds[0] / seconds[1]);
+    }
+}
+
+static void printStages(const char *name, double seconds, const PPlotStageCounts &before, const PPlotStageCounts &after, long runs) {
+    printf("redraw %-10s %10.1f us/draw  per draw: configure %.0f ranges %.0f ticks %.0f transforms %.0f emit %.0f\n", name,
+           seconds * 1e6, (after.mConfigure - before.mConfigure) / (double)runs, (after.mRanges - before.mRanges) / (double)runs,
+           (after.mTicks - before.mTicks) / (double)runs, (after.mTransforms - before.mTransforms) / (double)runs,
+           (after.mEmit - before.mEmit) / (double)runs);
+}
+
+// Repeated Draw of one plot: with the data marked changed, unchanged, and
+// into painters of two sizes. The emit pass draws into a DummyPainter.
+static void benchRedraw() {
+    PPlot plot;
+    PlotData *x = new PlotData();
+    PlotData *y = new PlotData();
+    for (long i = 0; i < 200000; i++) {
+        x->push_back(i * 0.01f);
+        y->push_back(sinf(i * 0.001f) * 100);
+    }
+    plot.mPlotDataContainer.AddXYPlot(x, y);
+    plot.mReuseLayout = true;
+    DummyPainter painter(800, 600);
+    DummyPainter wide(1000, 600);
+    plot.Draw(painter);
+
+    const char *names[] = {"changed", "unchanged", "resized"};
+    for (int mode = 0; mode < 3; mode++) {
+        PPlotStageCounts before = plot.GetStageCounts();
+        long runs = 0;
+        double seconds = timeIt([&]() {
+            if (mode == 0) {
+                plot.SetDataChanged();
+            }
+            plot.Draw(mode == 2 && runs % 2 ? wide : painter);
+            runs++;
+        });
+        printStages(names[mode], seconds, before, plot.GetStageCounts(), runs);
+    }
+}
+
+struct Workload {
+    long points; // per series
+    int series;
+    const char *drawer; // line, dot or bar
+    bool logAxes;
+    bool fast; // DataDrawerBase::SetDrawFast
+};
+
+static string workloadName(const Workload &workload) {
+    return string(workload.drawer) + (workload.logAxes ? "/log" : "/lin") + "/points:" +
+           to_string(workload.points) + "/series:" + to_string(workload.series) + "/fast:" + (workload.fast ? "1" : "0");
+}
+
+static void makeWorkloadPlot(const Workload &workload, PPlot &plot) {
+    for (int s = 0; s < workload.series; s++) {
+        PlotData *x = new PlotData();
+        PlotData *y = new PlotData();
+        x->reserve(workload.points);
+        y->reserve(workload.points);
+        for (long i = 0; i < workload.points; i++) {
+            // positive everywhere, so the same data works on log axes
+            x->push_back(i + 1);
+            y->push_back(50 + 40 * sinf(i * 0.01f + s));
+        }
+        DataDrawerBase *drawer;
+        if (strcmp(workload.drawer, "dot") == 0) {
+            drawer = new DotDataDrawer();
+        } else if (strcmp(workload.drawer, "bar") == 0) {
+            drawer = new BarDataDrawer();
+        } else {
+            drawer = new LineDataDrawer();
+        }
+        drawer->SetDrawFast(workload.fast);
+        LegendData *legend = new LegendData();
+        legend->SetDefaultValues(s);
+        legend->mName = "series " + to_string(s);
+        plot.mPlotDataContainer.AddXYPlot(x, y, legend, drawer);
+    }
+    plot.mXAxisSetup.mLogScale = workload.logAxes;
+    plot.mYAxisSetup.mLogScale = workload.logAxes;
+}
+
+// One chart drawn into an SVGPainter, recorded into a DisplayListPainter,
+// and replayed from memory and from a file into an SVGPainter.
+static void benchDisplayList() {
+    Workload workload = {100000, 4, "line", false, false};
+    PPlot plot;
+    makeWorkloadPlot(workload, plot);
+    size_t svgBytes = 0;
+    double draw = timeIt([&]() {
+        SVGPainter painter(800, 600);
+        plot.Draw(painter);
+        svgBytes = painter.getContent().size();
+    });
+    SVGPainter measure(800, 600);
+    DisplayListPainter displayList(measure);
+    double record = timeIt([&]() {
+        displayList.clear();
+        plot.SetDataChanged();
+        plot.Draw(displayList);
+    });
+    double replay = timeIt([&]() {
+        SVGPainter painter(800, 600);
+        displayList.replay(painter);
+    });
+    DummyPainter dummy(800, 600);
+    double replayDummy = timeIt([&]() { displayList.replay(dummy); });
+    const char *path = "bench_display_list.bin";
+    displayList.writeFile(path);
+    DisplayListPainter loaded(measure);
+    double load = timeIt([&]() { loaded.readFile(path); });
+    remove(path);
+    printf("display list %ld commands %zu bytes (svg %zu)  draw %.2f ms  record %.2f ms  replay svg %.2f ms  "
+           "replay dummy %.2f ms  read file %.2f ms\n",
+           displayList.getCommandCount(), displayList.getByteSize(), svgBytes, draw * 1e3, record * 1e3, replay * 1e3,
+           replayDummy * 1e3, load * 1e3);
+}
+
+// Rendering the same charts again through a RenderCache: the first pass
+// renders and stores them, the second is served from disk.
+static void benchRenderCache() {
+    const char *directory = "bench_render_cache";
+    vector<Workload> workloads = {{1000, 1, "line", false, false}, {100000, 1, "line", false, false},
+                                  {100000, 4, "dot", true, false}};
+    RenderCache cache(directory, 256 << 20);
+    cache.clear();
+    for (const Workload &workload : workloads) {
+        PPlot plot;
+        makeWorkloadPlot(workload, plot);
+        double hash = timeIt([&]() {
+            uint64_t key;
+            RenderCache::makeKey(plot, 800, 600, key);
+        });
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        size_t size = cache.render(plot, 800, 600).size();
+        double miss = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double hit = timeIt([&]() { cache.render(plot, 800, 600); });
+        printf("render cache %-40s %9zu bytes  hash %8.3f ms  miss %8.2f ms  hit %6.2f ms\n", workloadName(workload).c_str(),
+               size, hash * 1e3, miss * 1e3, hit * 1e3);
+    }
+    printf("render cache stats %s\n", cache.toJSON().c_str());
+    cache.clear();
+    error_code error;
+    filesystem::remove(directory, error);
+}
+
+// Eight stacked panels over one x range, redrawn after their data changed:
+// each panel computing the union range over all panels itself, and the
+// panels in an AxisGroup, which computes range and x ticks once per frame.
+static void benchAxisGroup() {
+    const int panels = 8;
+    PPlot plots[panels];
+    for (int p = 0; p < panels; p++) {
+        Workload workload = {200000, 1, "line", false, true};
+        makeWorkloadPlot(workload, plots[p]);
+    }
+    DummyPainter painter(800, 150);
+    double manual = timeIt([&]() {
+        for (int p = 0; p < panels; p++) {
+            float sharedMin = 0, sharedMax = 0;
+            for (int other = 0; other < panels; other++) {
+                float theMin, theMax;
+                plots[other].mPlotDataContainer.CalculateXRange(theMin, theMax);
+                sharedMin = other ? min(sharedMin, theMin) : theMin;
+                sharedMax = other ? max(sharedMax, theMax) : theMax;
+            }
+            plots[p].mXAxisSetup.SetMin(sharedMin);
+            plots[p].mXAxisSetup.SetMax(sharedMax);
+            plots[p].mXAxisSetup.SetAutoScale(false);
+            plots[p].SetDataChanged();
+            plots[p].Draw(painter);
+        }
+    });
+    AxisGroup group;
+    for (int p = 0; p < panels; p++) {
+        plots[p].mXAxisSetup.SetAutoScale(true);
+        plots[p].mReuseLayout = true;
+        group.AddPlot(&plots[p]);
+    }
+    long frames = 0;
+    double grouped = timeIt([&]() {
+        group.SetDataChanged();
+        for (int p = 0; p < panels; p++) {
+            plots[p].Draw(painter);
+        }
+        frames++;
+    });
+    printf("axis group %d panels  per panel union %7.2f ms/frame  axis group %7.2f ms/frame  %.2fx  "
+           "range scans %.1f tick fills %.1f per frame\n",
+           panels, manual * 1e3, grouped * 1e3, manual / grouped, group.GetRangeScans() / (double)frames,
+           group.GetTickFills() / (double)frames);
+}
+
+// A 10 x 10 grid of small fast mode line charts into one SVGPainter, with
+// and without shared axes, drawn panel by panel and by four threads. The
+// panels reuse their layout, so unchanged data is not scanned again.
+static void benchPlotGrid() {
+    const int size = 10;
+    vector<unique_ptr<PPlot>> plots;
+    PlotGrid grid(size, size);
+    for (int i = 0; i < size * size; i++) {
+        Workload workload = {20000 + 1000 * i, 1 + i % 3, "line", false, true};
+        plots.emplace_back(new PPlot());
+        makeWorkloadPlot(workload, *plots.back());
+        plots.back()->mMargins = PMargins(30, 5, 5, 20);
+        plots.back()->mReuseLayout = true;
+        grid.setPlot(i / size, i % size, plots.back().get());
+    }
+    grid.setSpacing(4);
+    for (int share = 0; share < 2; share++) {
+        grid.setShareX(share);
+        grid.setShareY(share);
+        string content[2];
+        double seconds[2];
+        {
+            SVGPainter painter(2000, 1500);
+            grid.draw(painter); // scans the data for the shared ranges
+        }
+        long scans = grid.getRangeScans();
+        long draws = 0;
+        for (int parallel = 0; parallel < 2; parallel++) {
+            grid.setThreadCount(parallel ? 4 : 1);
+            seconds[parallel] = timeIt([&]() {
+                SVGPainter painter(2000, 1500);
+                grid.draw(painter);
+                content[parallel] = painter.getContent();
+                draws++;
+            });
+        }
+        printf("plot grid %dx%d shared axes %-3s  one thread %7.2f ms  four threads %7.2f ms  %.2fx  %s  "
+               "range scans %.1f per draw\n",
+               size, size, share ? "yes" : "no", seconds[0] * 1e3, seconds[1] * 1e3, seconds[0] / seconds[1],
+               content[0] == content[1] ? "same output" : "OUTPUT DIFFERS", (grid.getRangeScans() - scans) / (double)draws);
+    }
+}
+
+// peak resident set size of the process so far, 0 where unknown; a high
+// water mark, so it is the largest case run yet, not the current one
+static long peakRSSKilobytes() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes there
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static vector<Workload> renderWorkloads(long maxPoints) {
+    vector<Workload> workloads;
+    for (long points = 1000; points <= maxPoints && points <= 100000000; points *= 10) {
+        workloads.push_back({points, 1, "line", false, false});
+    }
+    for (int series = 10; series <= 1000; series *= 10) {
+        workloads.push_back({1000, series, "line", false, false});
+    }
+    long large = maxPoints < 100000 ? maxPoints : 100000;
+    workloads.push_back({large, 1, "dot", false, false});
+    workloads.push_back({large, 1, "bar", false, false});
+    workloads.push_back({large, 1, "line", true, false});
+    for (long points = large; points <= maxPoints && points <= 100000000; points *= 10) {
+        workloads.push_back({points, 1, "line", false, true});
+    }
+    return workloads;
+}
+
+// Every run is a full Draw (the layout cache is invalidated) into a new painter.
+// render/ cases draw into an SVGPainter, compute/ cases into a DummyPainter,
+// which leaves just the layout and data drawing.
+static void benchRenderCase(const Workload &workload, bool compute, const string &name, bool json, bool first) {
+    PPlot plot;
+    makeWorkloadPlot(workload, plot);
+    RenderProfile profile;
+    long bytes = 0;
+    long runs = 0;
+    double seconds = timeIt([&]() {
+        plot.mProfile = runs > 0 ? &profile : nullptr; // the first run warms up
+        plot.SetDataChanged();
+        if (compute) {
+            DummyPainter painter(800, 600);
+            plot.Draw(painter);
+        } else {
+            SVGPainter painter(800, 600);
+            plot.Draw(painter);
+            bytes = painter.GetOutputSize();
+        }
+        runs++;
+    });
+    double points = (double)workload.points * workload.series;
+    double drawSeconds = profile.mDrawCount ? profile.mTotalSeconds / profile.mDrawCount : seconds;
+    if (json) {
+        printf("%s\n    {\"name\": \"%s\", \"iterations\": %ld, \"real_time\": %.0f, \"time_unit\": \"ns\", "
+               "\"points_per_second\": %.6g, \"bytes_per_second\": %.6g, \"bytes\": %ld, \"primitives\": %ld, "
+               "\"process_peak_rss_kb\": %ld, \"stages_ns\": {",
+               first ? "" : ",", name.c_str(), runs, drawSeconds * 1e9, points / drawSeconds, bytes / drawSeconds, bytes,
+               profile.mDrawCount ? profile.mPrimitives / profile.mDrawCount : 0, peakRSSKilobytes());
+        for (int stage = 0; stage < RenderProfile::kStageCount; stage++) {
+            printf("%s\"%s\": %.0f", stage ? ", " : "", RenderProfile::GetStageName(stage),
+                   profile.mDrawCount ? profile.mStageSeconds[stage] * 1e9 / profile.mDrawCount : 0.0);
+        }
+        printf("}}");
+    } else {
+        printf("%-46s %10.3f ms/draw  %8.2f Mpoints/s  %8.2f MB/s  %9ld bytes  process peak rss %ld KB\n", name.c_str(),
+               drawSeconds * 1e3, points / drawSeconds * 1e-6, bytes / drawSeconds * 1e-6, bytes, peakRSSKilobytes());
+    }
+}
+
+static void benchRender(long maxPoints, const char *filter, bool json) {
+    bool first = true;
+    if (json) {
+        printf("{\n  \"context\": {\"executable\": \"bench\", \"max_points\": %ld},\n  \"benchmarks\": [", maxPoints);
+    }
+    for (const Workload &workload : renderWorkloads(maxPoints)) {
+        for (int compute = 0; compute < 2; compute++) {
+            string name = (compute ? "compute/" : "render/") + workloadName(workload);
+            if (filter && name.find(filter) == string::npos) {
+                continue;
+            }
+            benchRenderCase(workload, compute, name, json, first);
+            first = false;
+        }
+    }
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    bool json = false;
+    long maxPoints = 1000000;
+    const char *filter = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--max-points") == 0 && i + 1 < argc) {
+            maxPoints = (long)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--max-points N] [--filter TEXT]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!json) {
+        benchTimeTicks();
+        benchDataAccess();
+        benchLineKernel();
+        benchBars();
+        benchRedraw();
+        benchDisplayList();
+        benchRenderCache();
+        benchPlotGrid();
+        benchAxisGroup();
+    }
+    benchRender(maxPoints, filter, json);
+    return 0;
+}
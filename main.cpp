@@ -4,30 +4,431 @@
 //  The main file for assignment 1; tests the data processing by producing
 //  some charts.
 //
+//  Run with --simplify [tolerance] to report how much the line
+//  simplification shrinks the example plots and how far it moves them.
+//  Run with --check [--tolerance T] [--golden-dir DIR] to render the
+//  charts and compare them with the checked in SVGs instead of writing
+//  them; with a tolerance numbers may differ by up to T. Each chart is
+//  also recorded into a DisplayListPainter and replayed, which must give
+//  the same SVG.
+//  Run with --profile to print the per stage RenderProfile and the
+//  ProfilingPainter statistics of each example plot as one JSON object
+//  per line.
+//
 //  Copyright 2019 David Kopec
 //
 
 #include "PPlot.h"
 #include "SVGPainter.h"
+#include "PNGPainter.h"
+#include "ProfilingPainter.h"
+#include "DisplayListPainter.h"
+#include "GoldenCompare.h"
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
 
 using namespace std;
 using namespace SVGChart;
 
-int main() {
+static const int exampleCount = 12; // MakeExamplePlot 1 to exampleCount
+// also rendered through PNGPainter: lines, text and a legend; bars; an image
+static const int pngExamples[] = {1, 5, 9};
+
+// A DummyPainter that also remembers the line segments it was asked to draw.
+class SegmentRecorder: public DummyPainter {
+public:
+    struct Segment { float x1, y1, x2, y2; };
+
+    SegmentRecorder(): DummyPainter(300, 300) {}
+    virtual void DrawLine (float inX1, float inY1, float inX2, float inY2) {
+        DummyPainter::DrawLine(inX1, inY1, inX2, inY2);
+        segments.push_back({inX1, inY1, inX2, inY2});
+    }
+
+    vector<Segment> segments;
+};
+
+static float distanceToSegment(float x, float y, const SegmentRecorder::Segment &s) {
+    float dx = s.x2 - s.x1, dy = s.y2 - s.y1;
+    float lengthSquared = dx * dx + dy * dy;
+    float t = lengthSquared > 0 ? ((x - s.x1) * dx + (y - s.y1) * dy) / lengthSquared : 0;
+    t = max(0.0f, min(1.0f, t));
+    float ex = s.x1 + t * dx - x, ey = s.y1 + t * dy - y;
+    return sqrt(ex * ex + ey * ey);
+}
+
+static void setSimplifyTolerance(PPlot &pplot, float tolerance) {
+    for (int i = 0; i < pplot.mPlotDataContainer.GetPlotCount(); i++) {
+        LineDataDrawer *drawer = dynamic_cast<LineDataDrawer *>(pplot.mPlotDataContainer.GetDataDrawer(i));
+        if (drawer) {
+            drawer->mSimplifyTolerance = tolerance;
+        }
+    }
+}
+
+// A series dense enough that most of its segments are sub-pixel.
+static void makeDensePlot(PPlot &pplot) {
+    PlotData *xData = new PlotData();
+    PlotData *yData = new PlotData();
+    for (int i = 0; i < 50000; i++) {
+        xData->push_back(i * 0.001f);
+        yData->push_back(sin(i * 0.0004f) + 0.002f * sin(i * 1.7f));
+    }
+    pplot.mPlotDataContainer.AddXYPlot(xData, yData, new LegendData());
+}
+
+// Draws the plot with and without simplification and prints the reduction
+// in line segments and the largest distance from an original vertex to the
+// simplified line.
+static void reportSimplification(const string &name, const function<void(PPlot &)> &make, float tolerance) {
+    SegmentRecorder original, simplified;
+    {
+        PPlot pplot;
+        make(pplot);
+        pplot.Draw(original);
+    }
+    {
+        PPlot pplot;
+        make(pplot);
+        setSimplifyTolerance(pplot, tolerance);
+        pplot.Draw(simplified);
+    }
+    // bucket the simplified segments so each vertex only looks at nearby ones
+    const int cellSize = 4;
+    const int cells = 300 / cellSize + 1;
+    vector<vector<size_t>> grid(cells * cells);
+    auto cellOf = [&](float v) { return max(0, min(cells - 1, (int)floor(v / cellSize))); };
+    for (size_t i = 0; i < simplified.segments.size(); i++) {
+        const SegmentRecorder::Segment &t = simplified.segments[i];
+        for (int cy = cellOf(min(t.y1, t.y2)); cy <= cellOf(max(t.y1, t.y2)); cy++) {
+            for (int cx = cellOf(min(t.x1, t.x2)); cx <= cellOf(max(t.x1, t.x2)); cx++) {
+                grid[cy * cells + cx].push_back(i);
+            }
+        }
+    }
+    float maxDeviation = 0;
+    for (const SegmentRecorder::Segment &s : original.segments) {
+        for (int end = 0; end < 2; end++) {
+            float x = end ? s.x2 : s.x1, y = end ? s.y2 : s.y1;
+            float nearest = HUGE_VALF;
+            int cx = cellOf(x), cy = cellOf(y);
+            // widen the search ring until it is certain nothing closer is outside it
+            for (int ring = 0; ring < cells && nearest > (ring - 1) * cellSize; ring++) {
+                for (int gy = max(0, cy - ring); gy <= min(cells - 1, cy + ring); gy++) {
+                    for (int gx = max(0, cx - ring); gx <= min(cells - 1, cx + ring); gx++) {
+                        if (max(abs(gx - cx), abs(gy - cy)) != ring) {
+                            continue;
+                        }
+                        for (size_t i : grid[gy * cells + gx]) {
+                            nearest = min(nearest, distanceToSegment(x, y, simplified.segments[i]));
+                        }
+                    }
+                }
+            }
+            maxDeviation = max(maxDeviation, nearest);
+        }
+    }
+    printf("%-14s %8zu -> %8zu segments (%5.1f%%), max deviation %.3f px\n", name.c_str(),
+           original.segments.size(), simplified.segments.size(),
+           original.segments.empty() ? 0.0 : 100.0 * simplified.segments.size() / original.segments.size(),
+           maxDeviation);
+}
+
+// Screen positions of the points of a drawn plot that hit testing covers,
+// computed the way PlotSpatialIndex does; NaN for the others.
+static void screenPoints(const PPlot &pplot, int plot, vector<float> &x, vector<float> &y) {
+    const PlotDataBase *xData = pplot.mPlotDataContainer.GetConstXData(plot);
+    const PlotDataBase *yData = pplot.mPlotDataContainer.GetConstYData(plot);
+    long size = min(xData->GetSize(), yData->GetSize());
+    PlotDataSpan xSpan = xData->GetSpan();
+    PlotDataSpan ySpan = yData->GetSpan();
+    const PRect &rect = pplot.GetPlotRect();
+    x.assign(size, NAN);
+    y.assign(size, NAN);
+    for (long i = 0; i < size; i++) {
+        float sx = pplot.mXTrafo->Transform(xSpan[i]);
+        float sy = pplot.mYTrafo->Transform(ySpan[i]);
+        if (sx >= rect.mX && sx <= rect.mX + rect.mW && sy >= rect.mY && sy <= rect.mY + rect.mH) {
+            x[i] = sx;
+            y[i] = sy;
+        }
+    }
+}
+
+// Compares FindNearestPoint, FindPointsInRect and SelectPointsInRect of a
+// drawn plot with a brute force search over all points. Marks points in the
+// plot's selections.
+static bool checkHitTesting(PPlot &pplot, string &difference) {
+    int plotCount = pplot.mPlotDataContainer.GetPlotCount();
+    vector<vector<float>> xs(plotCount), ys(plotCount);
+    for (int plot = 0; plot < plotCount; plot++) {
+        screenPoints(pplot, plot, xs[plot], ys[plot]);
+    }
+    char buffer[200];
+    for (int probe = 0; probe < 31 * 31; probe++) {
+        float px = (probe % 31) * 10 + 0.5f, py = (probe / 31) * 10 + 0.5f;
+        float maxDistance = probe % 2 ? 15.0f : 1000.0f;
+        float best = maxDistance;
+        bool found = false;
+        for (int plot = 0; plot < plotCount; plot++) {
+            for (size_t i = 0; i < xs[plot].size(); i++) {
+                float dx = xs[plot][i] - px, dy = ys[plot][i] - py;
+                float distance = sqrt(dx * dx + dy * dy);
+                if (distance < best) {
+                    best = distance;
+                    found = true;
+                }
+            }
+        }
+        int plot;
+        long point;
+        bool hit = pplot.FindNearestPoint(px, py, maxDistance, plot, point);
+        float distance = hit ? hypot(xs[plot][point] - px, ys[plot][point] - py) : 0;
+        if (hit != found || (hit && fabs(distance - best) > 1e-3f)) {
+            snprintf(buffer, sizeof(buffer), "nearest point to (%g, %g): %s %g, brute force %s %g", px, py,
+                     hit ? "found at" : "none", distance, found ? "found at" : "none", best);
+            difference = buffer;
+            return false;
+        }
+    }
+
+    const PRect &plotRect = pplot.GetPlotRect();
+    for (int plot = 0; plot < plotCount; plot++) {
+        for (int quadrant = 0; quadrant < 4; quadrant++) {
+            PRect rect;
+            rect.mW = plotRect.mW / 2;
+            rect.mH = plotRect.mH / 2;
+            rect.mX = plotRect.mX + (quadrant % 2) * rect.mW;
+            rect.mY = plotRect.mY + (quadrant / 2) * rect.mH;
+            vector<long> expected, found;
+            for (size_t i = 0; i < xs[plot].size(); i++) {
+                if (xs[plot][i] >= rect.mX && xs[plot][i] <= rect.mX + rect.mW && ys[plot][i] >= rect.mY &&
+                    ys[plot][i] <= rect.mY + rect.mH) {
+                    expected.push_back(i);
+                }
+            }
+            pplot.FindPointsInRect(plot, rect, found);
+            if (found != expected) {
+                snprintf(buffer, sizeof(buffer), "points of plot %d in quadrant %d: %zu, brute force %zu", plot,
+                         quadrant, found.size(), expected.size());
+                difference = buffer;
+                return false;
+            }
+
+            PlotDataSelection *selection = pplot.mPlotDataContainer.GetPlotDataSelection(plot);
+            if (!selection) {
+                continue;
+            }
+            PlotDataSelection before = *selection;
+            before.resize(max<long>(before.size(), pplot.mPlotDataContainer.GetConstYData(plot)->GetSize()));
+            pplot.SelectPointsInRect(plot, rect);
+            for (long i : expected) {
+                before[i] = 1;
+            }
+            if (*selection != before) {
+                snprintf(buffer, sizeof(buffer), "selection of plot %d in quadrant %d differs", plot, quadrant);
+                difference = buffer;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Multiplies the y values of every plot by 100 without changing the sizes.
+static void scaleValuesInPlace(PPlot &pplot) {
+    for (int i = 0; i < pplot.mPlotDataContainer.GetPlotCount(); i++) {
+        PlotData *yData = dynamic_cast<PlotData *>(pplot.mPlotDataContainer.GetYData(i));
+        for (size_t j = 0; yData && j < yData->size(); j++) {
+            (*yData)[j] *= 100;
+        }
+    }
+}
+
+static string drawSVG(PPlot &pplot) {
+    SVGPainter painter(300, 300);
+    pplot.Draw(painter);
+    return painter.getContent();
+}
+
+// Redraws ExamplePlot1 after editing its values in place, by default and
+// with the layout reused and SetDataChanged called, and compares both with a
+// plot built from the edited values.
+static bool checkInPlaceEdit(string &difference) {
+    PPlot fresh;
+    MakeExamplePlot1(fresh);
+    scaleValuesInPlace(fresh);
+    string expected = drawSVG(fresh);
+    for (int reuse = 0; reuse < 2; reuse++) {
+        PPlot pplot;
+        MakeExamplePlot1(pplot);
+        pplot.mReuseLayout = reuse;
+        drawSVG(pplot);
+        scaleValuesInPlace(pplot);
+        if (reuse) {
+            pplot.SetDataChanged();
+        }
+        if (drawSVG(pplot) != expected) {
+            difference = reuse ? "differs after SetDataChanged" : "differs from a fresh plot";
+            return false;
+        }
+    }
+    return true;
+}
+
+static string pngName(int example) {
+    return "ExamplePlot" + to_string(example) + ".png";
+}
+
+static void drawPNG(int example, PNGPainter &painter) {
+    PPlot pplot;
+    MakeExamplePlot(example, pplot);
+    pplot.Draw(painter);
+}
+
+// Renders test.svg and the ExamplePlot SVGs and compares them with the goldens,
+// then checks hit testing on each and redrawing after in place edits, and
+// compares the PNG goldens byte for byte. Returns the number of checks that
+// fail.
+static int checkGoldens(double tolerance, const string &goldenDir) {
+    int failures = 0;
+    for (int i = 0; i <= exampleCount; i++) {
+        string name = i == 0 ? "test.svg" : "ExamplePlot" + to_string(i) + ".svg";
+        PPlot pplot;
+        if (i == 0) {
+            MakePainterTester(pplot);
+        } else {
+            MakeExamplePlot(i, pplot);
+        }
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        SVGPainter painter(300, 300);
+        pplot.Draw(painter);
+        string actual = painter.getContent();
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        ifstream goldenFile(goldenDir + "/" + name);
+        stringstream golden;
+        golden << goldenFile.rdbuf();
+        string difference = "cannot read " + goldenDir + "/" + name;
+        bool same = goldenFile && compareSVG(golden.str(), actual, tolerance, difference);
+
+        SVGPainter measure(300, 300);
+        DisplayListPainter displayList(measure);
+        pplot.Draw(displayList);
+        SVGPainter replayed(300, 300);
+        displayList.replay(replayed);
+        if (same && replayed.getContent() != actual) {
+            same = false;
+            difference = "display list replay differs";
+        }
+        if (same && !checkHitTesting(pplot, difference)) {
+            same = false;
+        }
+        printf("%-4s %-18s %8.3f ms%s%s\n", same ? "ok" : "FAIL", name.c_str(), milliseconds, same ? "" : "  ",
+               same ? "" : difference.c_str());
+        failures += !same;
+    }
+
+    for (int example : pngExamples) {
+        string name = pngName(example);
+        ifstream goldenFile(goldenDir + "/" + name, ios::binary);
+        vector<unsigned char> golden((istreambuf_iterator<char>(goldenFile)), istreambuf_iterator<char>());
+        PNGPainter painter(300, 300);
+        drawPNG(example, painter);
+        vector<unsigned char> actual;
+        string difference;
+        if (!painter.encode(actual)) {
+            difference = "cannot encode";
+        } else if (!goldenFile) {
+            difference = "cannot read " + goldenDir + "/" + name;
+        } else if (actual != golden) {
+            size_t at = mismatch(actual.begin(), actual.begin() + min(actual.size(), golden.size()), golden.begin()).first -
+                        actual.begin();
+            difference = "differs from byte " + to_string(at) + " (" + to_string(actual.size()) + " bytes, golden " +
+                         to_string(golden.size()) + ")";
+        }
+        bool same = difference.empty();
+        printf("%-4s %s%s%s\n", same ? "ok" : "FAIL", name.c_str(), same ? "" : "  ", difference.c_str());
+        failures += !same;
+    }
+
+    string difference;
+    bool same = checkInPlaceEdit(difference);
+    printf("%-4s in place edit%s%s\n", same ? "ok" : "FAIL", same ? "" : "  ", difference.c_str());
+    failures += !same;
+    return failures;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        double tolerance = 0;
+        string goldenDir = ".";
+        for (int i = 2; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--tolerance") == 0) {
+                tolerance = atof(argv[i + 1]);
+            } else if (strcmp(argv[i], "--golden-dir") == 0) {
+                goldenDir = argv[i + 1];
+            }
+        }
+        return checkGoldens(tolerance, goldenDir) ? 1 : 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--simplify") == 0) {
+        float tolerance = argc > 2 ? atof(argv[2]) : 0.5f;
+        printf("line simplification, tolerance %.2f px\n", tolerance);
+        for (int i = 1; i <= exampleCount; i++) {
+            reportSimplification("ExamplePlot" + to_string(i), [i](PPlot &pplot) { MakeExamplePlot(i, pplot); },
+                                 tolerance);
+        }
+        reportSimplification("DensePlot", makeDensePlot, tolerance);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--profile") == 0) {
+        for (int i = 1; i <= exampleCount; i++) {
+            PPlot pplot;
+            MakeExamplePlot(i, pplot);
+            RenderProfile profile;
+            pplot.mProfile = &profile;
+            SVGPainter painter(300, 300);
+            ProfilingPainter profilingPainter(painter);
+            pplot.Draw(profilingPainter);
+            printf("{\"plot\":\"ExamplePlot%d\",\"profile\":%s,\"painter\":%s}\n", i, profile.toJSON().c_str(),
+                   profilingPainter.toJSON().c_str());
+        }
+        return 0;
+    }
+
     PPlot pplot;
     MakePainterTester(pplot);
     SVGPainter painter(300, 300);
     pplot.Draw(painter);
     painter.writeFile("test.svg");
     
-    for (int i = 1; i <= 8; i++) {
+    for (int i = 1; i <= exampleCount; i++) {
         PPlot pplot;
         MakeExamplePlot(i, pplot);
         SVGPainter painter(300, 300);
         pplot.Draw(painter);
         painter.writeFile("ExamplePlot" + to_string(i) + ".svg");
     }
+
+    for (int example : pngExamples) {
+        PNGPainter painter(300, 300);
+        drawPNG(example, painter);
+        if (!painter.writeFile(pngName(example))) {
+            fprintf(stderr, "cannot write %s\n", pngName(example).c_str());
+            return 1;
+        }
+    }
     
     return 0;
 }